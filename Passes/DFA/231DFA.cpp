@@ -0,0 +1,56 @@
+//===- 231DFA.cpp - Shared state of the CSE 231 dataflow framework ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the command line options shared by all the analyses
+// built on 231DFA.h and their module drivers, and the solver selection of the
+// may-point-to passes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "231DFA.h"
+#include "FlowInsensitivePointsTo.h"
+#include "ParallelDriver.h"
+
+using namespace llvm;
+
+cl::opt<bool> llvm::DFAPrintStatistics("cse231-dfa-stats",
+                                       cl::desc("Print worklist and memory statistics of the dataflow analyses"),
+                                       cl::init(false));
+
+cl::opt<DFAWorklistKind> llvm::DFAWorklistMode(
+    "cse231-dfa-worklist",
+    cl::desc("Scheduling of the dataflow worklist"),
+    cl::values(clEnumValN(DFAWorklistKind::InstructionFIFO, "fifo",
+                          "FIFO queue of instructions"),
+               clEnumValN(DFAWorklistKind::BlockPriority, "rpo",
+                          "Basic blocks in reverse postorder (postorder for backward analyses)")),
+    cl::init(DFAWorklistKind::BlockPriority));
+
+cl::opt<bool> llvm::DFAVerifyIncremental("cse231-dfa-verify-incremental",
+                                         cl::desc("Check every incremental dataflow update against a run from scratch"),
+                                         cl::init(false));
+
+cl::opt<unsigned> llvm::DFAThreads("cse231-dfa-threads",
+                                   cl::desc("Number of threads of the parallel dataflow passes (0: one per hardware thread)"),
+                                   cl::init(0));
+
+cl::opt<std::string> llvm::DFAOutputFile("cse231-dfa-output",
+                                         cl::desc("Write the dataflow results to this file in binary form instead of printing them"),
+                                         cl::value_desc("filename"), cl::init(""));
+
+cl::opt<PointsToSolverKind> llvm::PointsToSolver(
+    "cse231-maypointto-solver",
+    cl::desc("Solver of the may-point-to analysis"),
+    cl::values(clEnumValN(PointsToSolverKind::FlowSensitive, "flow-sensitive",
+                          "A solution per edge, by the dataflow framework"),
+               clEnumValN(PointsToSolverKind::Andersen, "andersen",
+                          "One solution per function, by inclusion constraints"),
+               clEnumValN(PointsToSolverKind::Steensgaard, "steensgaard",
+                          "One solution per function, by unification")),
+    cl::init(PointsToSolverKind::FlowSensitive));
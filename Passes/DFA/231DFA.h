@@ -14,20 +14,54 @@
 #ifndef LLVM_TRANSFORMS_231DFA_H
 #define LLVM_TRANSFORMS_231DFA_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/InitializePasses.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Function.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <deque>
+#include <functional>
 #include <map>
+#include <queue>
 #include <utility>
 #include <vector>
 
 namespace llvm {
 
 
+// Index of an instruction that no longer exists
+const unsigned DFADeletedIndex = ~0u;
+
+/*
+ * Correspondence between the instruction indices of two runs of an analysis on
+ * the same function, built by DataFlowAnalysis::updateWorklistAlgorithm.
+ */
+struct DFAIndexRemapping {
+	// Maximal runs of consecutive old indices that still have consecutive new indices
+	struct Range {
+		unsigned OldFirst;
+		unsigned NewFirst;
+		unsigned Length;
+	};
+
+	// New index of every old index, or DFADeletedIndex
+	std::vector<unsigned> NewIndex;
+	// The runs in increasing order of OldFirst. Deleted instructions are in none.
+	std::vector<Range> Ranges;
+
+	unsigned lookup(unsigned idx) const {
+		return idx < NewIndex.size() ? NewIndex[idx] : DFADeletedIndex;
+	}
+};
+
 /*
  * This is the base class to represent information in a dataflow analysis.
  * For a specific analysis, you need to create a sublcass of it.
@@ -36,6 +70,7 @@ class Info {
   public:
     Info() {}
     Info(const Info& other) {}
+    Info& operator=(const Info&) = default;
     virtual ~Info() {};
 
     /*
@@ -54,18 +89,160 @@ class Info {
      */
     static bool equals(Info * info1, Info * info2);
     /*
-     * Join two pieces of information.
-     * The third parameter points to the result.
+     * Join src into dst in place.
+     * Returns true if dst changed, so callers need no separate equals().
      *
      * Direction:
      *   In your subclass you need to implement this function.
      */
-    static Info* join(Info * info1, Info * info2, Info * result);
+    static bool joinInto(Info * dst, Info * src);
+    /*
+     * Replace every instruction index held by this information with its new
+     * index in mapping, dropping the ones of deleted instructions.
+     * Only used by DataFlowAnalysis::updateWorklistAlgorithm.
+     *
+     * Direction:
+     *   In your subclass you need to implement this function to support incremental updates.
+     */
+    void remap(const DFAIndexRemapping & mapping);
+};
+
+/*
+ * True for the opcodes the analyses treat as defining a new value: arithmetic,
+ * bitwise, alloca, load, getelementptr, comparisons and select.
+ * Casts, calls, phi nodes and terminators are not in this set.
+ */
+inline bool isDefiningOpcode(unsigned opcode) {
+	switch (opcode) {
+	case Instruction::Add:
+	case Instruction::FAdd:
+	case Instruction::Sub:
+	case Instruction::FSub:
+	case Instruction::Mul:
+	case Instruction::FMul:
+	case Instruction::UDiv:
+	case Instruction::SDiv:
+	case Instruction::FDiv:
+	case Instruction::URem:
+	case Instruction::SRem:
+	case Instruction::FRem:
+	case Instruction::Shl:
+	case Instruction::LShr:
+	case Instruction::AShr:
+	case Instruction::And:
+	case Instruction::Or:
+	case Instruction::Xor:
+	case Instruction::Alloca:
+	case Instruction::Load:
+	case Instruction::GetElementPtr:
+	case Instruction::ICmp:
+	case Instruction::FCmp:
+	case Instruction::Select:
+		return true;
+	default:
+		return false;
+	}
+}
+
+inline bool isDefiningInstr(const Instruction * I) {
+	return isDefiningOpcode(I->getOpcode());
+}
+
+// Set by -cse231-dfa-stats: print worklist and memory statistics after each analysis.
+extern cl::opt<bool> DFAPrintStatistics;
+
+// Scheduling strategy of runWorklistAlgorithm, selected by -cse231-dfa-worklist.
+enum class DFAWorklistKind { InstructionFIFO, BlockPriority };
+extern cl::opt<DFAWorklistKind> DFAWorklistMode;
+
+// Set by -cse231-dfa-verify-incremental: check every incremental update against a full run.
+extern cl::opt<bool> DFAVerifyIncremental;
+
+/*
+ * Pool owning every Info object created while analyzing one function.
+ * Objects are carved out of a bump allocator; released objects are kept on a
+ * free list and reused by later allocations. Everything is destroyed in bulk
+ * when the pool dies.
+ */
+template <class Info>
+class InfoPool {
+  public:
+    InfoPool() : NumCreated(0), NumLive(0), PeakLive(0) {}
+    InfoPool(const InfoPool &) = delete;
+    InfoPool &operator=(const InfoPool &) = delete;
+
+    ~InfoPool() {
+    	for (Info * info : Objects)
+    		info->~Info();
+    }
+
+    template <typename... ArgTs>
+    Info * create(ArgTs &&... args) {
+    	Info * info;
+    	if (!FreeList.empty()) {
+    		info = FreeList.back();
+    		FreeList.pop_back();
+    		info->~Info();
+    	} else {
+    		info = static_cast<Info *>(Allocator.Allocate(sizeof(Info), alignof(Info)));
+    		Objects.push_back(info);
+    	}
+    	new (info) Info(std::forward<ArgTs>(args)...);
+
+    	NumCreated++;
+    	NumLive++;
+    	PeakLive = std::max(PeakLive, NumLive);
+    	return info;
+    }
+
+    /*
+     * Hand an object back to the pool. It must not be used afterwards.
+     */
+    void release(Info * info) {
+    	assert(NumLive > 0 && "Releasing more objects than were created.");
+    	FreeList.push_back(info);
+    	NumLive--;
+    }
+
+    unsigned getNumCreated() const { return NumCreated; }
+    unsigned getPeakLive() const { return PeakLive; }
+    size_t getArenaBytes() const { return Allocator.getTotalMemory(); }
+
+    void printStatistics(raw_ostream &OS) const {
+    	OS << "Info objects created: " << NumCreated << "\n";
+    	OS << "Info objects live at peak: " << PeakLive << "\n";
+    	OS << "Info slots allocated: " << Objects.size() << "\n";
+    	OS << "Peak arena memory (bytes): " << Allocator.getTotalMemory() << "\n";
+    }
+
+  private:
+    BumpPtrAllocator Allocator;
+    // Every slot ever carved out of Allocator, live or on the free list
+    std::vector<Info *> Objects;
+    std::vector<Info *> FreeList;
+    unsigned NumCreated;
+    unsigned NumLive;
+    unsigned PeakLive;
+};
+
+// Counters of the work done by runWorklistAlgorithm, reported by printStatistics
+struct WorklistStatistics {
+	unsigned FlowFunctionCalls = 0;
+	unsigned WorklistPushes = 0;
+	unsigned WorklistPops = 0;
+	// Calls to Info::joinInto, both when combining incoming edges and when
+	// merging a flow function result into an edge
+	unsigned Joins = 0;
 };
 
 /*
  * This is the base template class to represent the generic dataflow analysis framework
  * For a specific analysis, you need to create a sublcass of it.
+ *
+ * Every edge starts from Bottom and only moves up by Info::joinInto, so Bottom
+ * must be the identity of the join. For a may analysis joined by union it is the
+ * empty set; for a must analysis joined by intersection it is the set of
+ * everything, the top of the must lattice (see IntersectionSetInfo).
  */
 template <class Info, bool Direction>
 class DataFlowAnalysis {
@@ -76,14 +253,49 @@ class DataFlowAnalysis {
 		std::map<unsigned, Instruction *> IndexToInstr;
 		// Instruction to index map
 		std::map<Instruction *, unsigned> InstrToIndex;
-		// Edge to information map
-		std::map<Edge, Info *> EdgeToInfo;
-		// The bottom of the lattice
+		// Edges sorted by (source, destination). The position of an edge is its id.
+		std::vector<Edge> Edges;
+		// Information of each edge, indexed by edge id
+		std::vector<Info *> EdgeInfos;
+		// Compressed adjacency indexed by instruction index:
+		//   the outgoing edges of n are the ids in [SuccOffsets[n], SuccOffsets[n + 1]),
+		//   the incoming edges of n are PredEdgeIds[PredOffsets[n]] ... PredEdgeIds[PredOffsets[n + 1] - 1].
+		std::vector<unsigned> SuccOffsets;
+		std::vector<unsigned> PredOffsets;
+		std::vector<unsigned> PredEdgeIds;
+		// Edges collected by addEdge until buildAdjacency() freezes them
+		std::vector<std::pair<Edge, Info *>> PendingEdges;
+		// The bottom of the lattice, the identity of Info::joinInto
 	    Info Bottom;
 	    // The initial state of the analysis
 		Info InitialState;
 		// EntryInstr points to the first instruction to be processed in the analysis
 		Instruction * EntryInstr;
+		// Owner of every Info created during the analysis except Bottom and InitialState
+		InfoPool<Info> Pool;
+		// Blocks passed to invalidateBlock since the last run or update. They may
+		// have been deleted, so they are only compared, never dereferenced.
+		SmallPtrSet<BasicBlock *, 8> ChangedBlocks;
+		// Instructions passed to revisit by the flow function being run
+		std::vector<unsigned> Revisits;
+
+		/*
+		 * Allocate an Info from the pool of this analysis.
+		 * The arguments are forwarded to the constructor of Info.
+		 */
+		template <typename... ArgTs>
+		Info * allocateInfo(ArgTs &&... args) {
+			return Pool.create(std::forward<ArgTs>(args)...);
+		}
+
+		/*
+		 * Give an Info obtained from allocateInfo back to the pool.
+		 * Bottom and InitialState are not owned by the pool and are ignored.
+		 */
+		void releaseInfo(Info * info) {
+			if (info != &Bottom && info != &InitialState)
+				Pool.release(info);
+		}
 
 
 		/*
@@ -124,10 +336,8 @@ class DataFlowAnalysis {
 		void getIncomingEdges(unsigned index, std::vector<unsigned> * IncomingEdges) {
 			assert(IncomingEdges->size() == 0 && "IncomingEdges should be empty.");
 
-			for (auto const &it : EdgeToInfo) {
-				if (it.first.second == index)
-					IncomingEdges->push_back(it.first.first);
-			}
+			for (unsigned edgeId : getIncomingEdgeIds(index))
+				IncomingEdges->push_back(Edges[edgeId].first);
 
 			return;
 		}
@@ -140,28 +350,160 @@ class DataFlowAnalysis {
 		void getOutgoingEdges(unsigned index, std::vector<unsigned> * OutgoingEdges) {
 			assert(OutgoingEdges->size() == 0 && "OutgoingEdges should be empty.");
 
-			for (auto const &it : EdgeToInfo) {
-				if (it.first.first == index)
-					OutgoingEdges->push_back(it.first.second);
-			}
+			for (unsigned edgeId = SuccOffsets[index]; edgeId < SuccOffsets[index + 1]; ++edgeId)
+				OutgoingEdges->push_back(Edges[edgeId].second);
 
 			return;
 		}
 
 		/*
 		 * Utility function:
-		 *   Insert an edge to EdgeToInfo.
+		 *   Get the ids of the incoming edges of the instruction identified by index,
+		 *   ordered by source index.
+		 */
+		ArrayRef<unsigned> getIncomingEdgeIds(unsigned index) const {
+			return makeArrayRef(PredEdgeIds.data() + PredOffsets[index],
+			                    PredEdgeIds.data() + PredOffsets[index + 1]);
+		}
+
+		/*
+		 * Utility function:
+		 *   Get the id of the edge src -> dst. The edge must exist.
+		 */
+		unsigned getEdgeId(unsigned src, unsigned dst) const {
+			auto first = Edges.begin() + SuccOffsets[src];
+			auto last = Edges.begin() + SuccOffsets[src + 1];
+			auto it = std::lower_bound(first, last, std::make_pair(src, dst));
+			assert(it != last && *it == std::make_pair(src, dst) && "Edge does not exist.");
+			return it - Edges.begin();
+		}
+
+		/*
+		 * Utility function:
+		 *   Join the information of all incoming edges of the instruction identified by index.
+		 *   The result is a new Info from the pool, owned by the caller.
+		 */
+		Info * joinIncoming(unsigned index) {
+			Info * combined = allocateInfo(Bottom);
+			for (unsigned edgeId : getIncomingEdgeIds(index)) {
+				Stats.Joins++;
+				Info::joinInto(combined, EdgeInfos[edgeId]);
+			}
+			return combined;
+		}
+
+		/*
+		 * Utility function:
+		 *   Use info as the result of a flow function for all of its outgoing edges.
+		 *   Takes ownership of info.
+		 */
+		void shareOutgoingInfo(Info * info, unsigned numOutgoing, std::vector<Info *> & Infos) {
+			Infos.assign(numOutgoing, info);
+			if (numOutgoing == 0)
+				releaseInfo(info);
+		}
+
+		/*
+		 * Utility function:
+		 *   Join info into the information of an edge. Returns true if the edge changed.
+		 *   Edges start out pointing at Bottom or InitialState and get their own copy
+		 *   the first time they change.
+		 */
+		bool joinIntoEdge(unsigned edgeId, Info * info) {
+			Info * edgeInfo = EdgeInfos[edgeId];
+			Stats.Joins++;
+			if (edgeInfo != &Bottom && edgeInfo != &InitialState)
+				return Info::joinInto(edgeInfo, info);
+
+			Info * copy = allocateInfo(*edgeInfo);
+			if (!Info::joinInto(copy, info)) {
+				releaseInfo(copy);
+				return false;
+			}
+			EdgeInfos[edgeId] = copy;
+			return true;
+		}
+
+		/*
+		 * Utility function:
+		 *   Run the flow function of the instruction identified by index again, although
+		 *   none of its incoming edges changed. For analyses that keep part of their
+		 *   information outside the edges, such as a lattice value per SSA value, and
+		 *   queue the users of a value when it changes.
+		 */
+		void revisit(unsigned index) {
+			Revisits.push_back(index);
+		}
+
+		/*
+		 * Utility function:
+		 *   Insert an edge to the pending edge list.
 		 *   The default initial value for each edge is bottom.
+		 *   If the same edge is added twice, the first content is kept.
 		 */
 		void addEdge(Instruction * src, Instruction * dst, Info * content) {
 			Edge edge = std::make_pair(InstrToIndex[src], InstrToIndex[dst]);
-			if (EdgeToInfo.count(edge) == 0)
-				EdgeToInfo[edge] = content;
+			PendingEdges.push_back(std::make_pair(edge, content));
+			return;
+		}
+
+		/*
+		 * Freeze the pending edges into Edges/EdgeInfos and build the compressed
+		 * predecessor and successor arrays. Called once the map is initialized.
+		 */
+		void buildAdjacency() {
+			std::stable_sort(PendingEdges.begin(), PendingEdges.end(),
+			                 [](const std::pair<Edge, Info *> &a, const std::pair<Edge, Info *> &b) {
+			                 	return a.first < b.first;
+			                 });
+
+			Edges.clear();
+			EdgeInfos.clear();
+			for (auto const &it : PendingEdges) {
+				if (!Edges.empty() && Edges.back() == it.first)
+					continue;
+				Edges.push_back(it.first);
+				EdgeInfos.push_back(it.second);
+			}
+			PendingEdges.clear();
+			PendingEdges.shrink_to_fit();
+
+			unsigned numNodes = IndexToInstr.size();
+			SuccOffsets.assign(numNodes + 1, 0);
+			PredOffsets.assign(numNodes + 1, 0);
+			for (auto const &edge : Edges) {
+				SuccOffsets[edge.first + 1]++;
+				PredOffsets[edge.second + 1]++;
+			}
+			for (unsigned i = 0; i < numNodes; ++i) {
+				SuccOffsets[i + 1] += SuccOffsets[i];
+				PredOffsets[i + 1] += PredOffsets[i];
+			}
+
+			// Edges are sorted by source, so every predecessor list ends up sorted as well.
+			PredEdgeIds.resize(Edges.size());
+			std::vector<unsigned> cursor(PredOffsets.begin(), PredOffsets.end() - 1);
+			for (unsigned edgeId = 0; edgeId < Edges.size(); ++edgeId)
+				PredEdgeIds[cursor[Edges[edgeId].second]++] = edgeId;
+
 			return;
 		}
 
 		/*
-		 * Initialize EdgeToInfo and EntryInstr for a forward analysis.
+		 * Drop the edges and indices of a previous run so the map can be built again.
+		 */
+		void clearMap() {
+			for (Info * info : EdgeInfos)
+				releaseInfo(info);
+			Edges.clear();
+			EdgeInfos.clear();
+			IndexToInstr.clear();
+			InstrToIndex.clear();
+			EntryInstr = nullptr;
+		}
+
+		/*
+		 * Initialize the edges and EntryInstr for a forward analysis.
 		 */
 		void initializeForwardMap(Function * func) {
 			assignIndiceToInstrs(func);
@@ -208,6 +550,7 @@ class DataFlowAnalysis {
 			EntryInstr = (Instruction *) &((func->front()).front());
 			addEdge(nullptr, EntryInstr, &InitialState);
 
+			buildAdjacency();
 			return;
 		}
 
@@ -261,6 +604,7 @@ class DataFlowAnalysis {
 			EntryInstr = (Instruction *) &((func->back()).back());
 			addEdge(nullptr, EntryInstr, &InitialState);
 
+			buildAdjacency();
 			return;
 		}
 
@@ -270,6 +614,8 @@ class DataFlowAnalysis {
      *   std::vector<unsigned> & IncomingEdges: the vector of the indices of the source instructions of the incoming edges.
      *   std::vector<unsigned> & IncomingEdges: the vector of indices of the source instructions of the outgoing edges.
      *   std::vector<Info *> & Infos: the vector of the newly computed information for each outgoing eages.
+     *     Each element must come from allocateInfo. The same Info may be used for several edges;
+     *     the worklist algorithm releases every distinct element once it has been joined.
      *
      * Direction:
      * 	 Implement this function in subclasses.
@@ -285,6 +631,17 @@ class DataFlowAnalysis {
 
     virtual ~DataFlowAnalysis() {}
 
+    typedef Info InfoType;
+
+    /*
+     * Call fn(src, dst, info) for every edge, in the order print() uses.
+     */
+    template <typename Fn>
+    void forEachEdge(Fn fn) {
+    	for (unsigned edgeId = 0; edgeId < Edges.size(); ++edgeId)
+    		fn(Edges[edgeId].first, Edges[edgeId].second, EdgeInfos[edgeId]);
+    }
+
     /*
      * Print out the analysis results.
      *
@@ -293,9 +650,9 @@ class DataFlowAnalysis {
      * 	 The autograder will check the output of this function.
      */
     void print() {
-			for (auto const &it : EdgeToInfo) {
-				errs() << "Edge " << it.first.first << "->" "Edge " << it.first.second << ":";
-				(it.second)->print();
+			for (unsigned edgeId = 0; edgeId < Edges.size(); ++edgeId) {
+				errs() << "Edge " << Edges[edgeId].first << "->" "Edge " << Edges[edgeId].second << ":";
+				EdgeInfos[edgeId]->print();
 			}
     }
 
@@ -303,8 +660,73 @@ class DataFlowAnalysis {
     	return InstrToIndex;
     }
 
+    /*
+     * Index of I, or 0 if I is not an instruction of the analyzed function.
+     */
+    unsigned getIndexOf(Instruction * I) const {
+    	auto it = InstrToIndex.find(I);
+    	return it == InstrToIndex.end() ? 0 : it->second;
+    }
+
+    /*
+     * Index of the instruction whose edges hold the information of I: the
+     * first phi node of its block for a phi node, I itself otherwise.
+     */
+    unsigned getEdgeIndexOf(Instruction * I) const {
+    	if (isa<PHINode>(I))
+    		I = &I->getParent()->front();
+    	return getIndexOf(I);
+    }
+
+    /*
+     * Instruction with index idx, or nullptr.
+     */
+    Instruction * getInstrOf(unsigned idx) const {
+    	auto it = IndexToInstr.find(idx);
+    	return it == IndexToInstr.end() ? nullptr : it->second;
+    }
+
+    /*
+     * Call fn(info) for the information of every edge entering I in the direction
+     * of the analysis: the state before I for a forward analysis, after it for a
+     * backward one. Stops early, returning true, as soon as fn returns true.
+     *
+     * Only the first phi node of a block has edges, and the phi nodes of a block
+     * run together, so any of them reads the edges of the first one: the state
+     * before all of them, or after all of them for a backward analysis.
+     */
+    template <typename Fn>
+    bool anyIncomingInfo(Instruction * I, Fn fn) const {
+    	unsigned index = getEdgeIndexOf(I);
+    	if (index == 0)
+    		return false;
+    	for (unsigned edgeId : getIncomingEdgeIds(index)) {
+    		if (fn(static_cast<const Info &>(*EdgeInfos[edgeId])))
+    			return true;
+    	}
+    	return false;
+    }
+
+    /*
+     * Like anyIncomingInfo for the edges leaving I in the direction of the analysis.
+     */
+    template <typename Fn>
+    bool anyOutgoingInfo(Instruction * I, Fn fn) const {
+    	unsigned index = getEdgeIndexOf(I);
+    	if (index == 0)
+    		return false;
+    	for (unsigned edgeId = SuccOffsets[index]; edgeId < SuccOffsets[index + 1]; ++edgeId) {
+    		if (fn(static_cast<const Info &>(*EdgeInfos[edgeId])))
+    			return true;
+    	}
+    	return false;
+    }
+
     std::map<Edge, Info *> getEdgeToInfo(){
-    	return EdgeToInfo;
+    	std::map<Edge, Info *> edgeToInfo;
+    	for (unsigned edgeId = 0; edgeId < Edges.size(); ++edgeId)
+    		edgeToInfo[Edges[edgeId]] = EdgeInfos[edgeId];
+    	return edgeToInfo;
     }
 
     /*
@@ -313,12 +735,13 @@ class DataFlowAnalysis {
      * (2) Initialize the worklist
      * (3) Compute until the worklist is empty
      *
-     * Direction:
-     *   Implement the rest of the function.
-     *   You may not change anything before "// (2) Initialize the worklist".
+     * Steps (2) and (3) depend on -cse231-dfa-worklist, see runInstructionWorklist
+     * and runBlockWorklist.
      */
     void runWorklistAlgorithm(Function * func) {
-    	std::deque<unsigned> worklist;
+    	clearMap();
+    	ChangedBlocks.clear();
+    	Stats = WorklistStatistics();
 
     	// (1) Initialize info of each edge to bottom
     	if (Direction)
@@ -328,36 +751,367 @@ class DataFlowAnalysis {
 
     	assert(EntryInstr != nullptr && "Entry instruction is null.");
 
-    	// (2) Initialize the work list
-    	for (std::map<unsigned, Instruction *>::iterator it=IndexToInstr.begin(); it!=IndexToInstr.end(); ++it){
-    		if(it->first == 0)
+    	runWorklist(func, std::vector<bool>(IndexToInstr.size(), true));
+    }
+
+    /*
+     * Record that block was added to the function, is about to be deleted, or that
+     * instructions were inserted into it, removed from it or had their operands or
+     * successors changed. Every block touched by a transformation must be reported
+     * before calling updateWorklistAlgorithm, including the blocks of the users of
+     * a value that was replaced.
+     */
+    void invalidateBlock(BasicBlock * block) {
+    	ChangedBlocks.insert(block);
+    }
+
+    void invalidateInstruction(Instruction * I) {
+    	invalidateBlock(I->getParent());
+    }
+
+    /*
+     * Bring the results of a previous runWorklistAlgorithm up to date with func
+     * after the changes reported by invalidateBlock.
+     *
+     * Instructions are numbered again and the information that survives is remapped
+     * to the new indices. The edges leaving an instruction of a changed block, or an
+     * instruction whose outgoing edges are not the same as before, are reset to
+     * bottom, along with every edge reachable from them in the direction of the
+     * analysis. Nothing else can depend on the changes, so the other edges keep their
+     * fixpoint values and the worklist only visits the instructions that were reset.
+     *
+     * With -cse231-dfa-verify-incremental the result is checked against a run
+     * from scratch.
+     */
+    void updateWorklistAlgorithm(Function * func) {
+    	if (EntryInstr == nullptr) {
+    		runWorklistAlgorithm(func);
+    		return;
+    	}
+    	Stats = WorklistStatistics();
+
+    	std::vector<Edge> oldEdges;
+    	std::vector<Info *> oldInfos;
+    	std::map<unsigned, Instruction *> oldIndexToInstr;
+    	oldEdges.swap(Edges);
+    	oldInfos.swap(EdgeInfos);
+    	oldIndexToInstr.swap(IndexToInstr);
+    	InstrToIndex.clear();
+    	EntryInstr = nullptr;
+
+    	if (Direction)
+    		initializeForwardMap(func);
+    	else
+    		initializeBackwardMap(func);
+
+    	// New index of every old one. Old instructions may be dangling pointers, so
+    	// they are only looked up, never dereferenced.
+    	unsigned numNodes = IndexToInstr.size();
+    	DFAIndexRemapping mapping;
+    	std::vector<unsigned> &newIndex = mapping.NewIndex;
+    	newIndex.assign(oldIndexToInstr.size(), DFADeletedIndex);
+    	std::vector<bool> hasOld(numNodes, false);
+    	bool identity = oldIndexToInstr.size() == numNodes;
+    	for (auto const &it : oldIndexToInstr) {
+    		auto found = InstrToIndex.find(it.second);
+    		if (found == InstrToIndex.end()) {
+    			identity = false;
     			continue;
-    		worklist.push_back(it->first);
+    		}
+    		newIndex[it.first] = found->second;
+    		DFAIndexRemapping::Range *last = mapping.Ranges.empty() ? nullptr : &mapping.Ranges.back();
+    		if (last && last->OldFirst + last->Length == it.first && last->NewFirst + last->Length == found->second)
+    			last->Length++;
+    		else
+    			mapping.Ranges.push_back({it.first, found->second, 1});
+    		hasOld[found->second] = true;
+    		identity = identity && found->second == it.first;
+    	}
+
+    	// Old edges whose source still exists, under the new indices and sorted like
+    	// Edges. A deleted destination sorts after all the others of its source.
+    	std::vector<std::pair<Edge, unsigned>> oldMapped;
+    	for (unsigned edgeId = 0; edgeId < oldEdges.size(); ++edgeId) {
+    		unsigned src = newIndex[oldEdges[edgeId].first];
+    		if (src != DFADeletedIndex)
+    			oldMapped.push_back(std::make_pair(std::make_pair(src, newIndex[oldEdges[edgeId].second]), edgeId));
     	}
+    	if (!identity)
+    		std::sort(oldMapped.begin(), oldMapped.end());
 
-    	// (3) Compute until the work list is empty
-    	while(worklist.size() != 0){
-    		unsigned idx = worklist.front();
-    		Instruction * instr = IndexToInstr[idx];
-    		worklist.pop_front();
-
-    		std::vector<unsigned> incomingNode, outgoingNode;
-    		getIncomingEdges(idx, &incomingNode);
-    		getOutgoingEdges(idx, &outgoingNode);
-
-    		std::vector<Info *> infos;
-    		// compute flow function
-    		flowfunction(instr, incomingNode, outgoingNode, infos);
-
-    		for (unsigned i = 0; i < outgoingNode.size(); ++i){
-    			Info * new_info = new Info();
-    			new_info = (Info*)Info::join(infos[i], EdgeToInfo[std::make_pair(idx, outgoingNode[i])], new_info);
-    			if(!Info::equals(EdgeToInfo[std::make_pair(idx, outgoingNode[i])], new_info)){
-    				EdgeToInfo[std::make_pair(idx, outgoingNode[i])] = new_info;
-    				worklist.push_back(outgoingNode[i]);
-    			}
+    	// Match the new edges with the old ones. oldEdgeIds[e] is the old id of
+    	// edge e, or DFADeletedIndex if it is new. An instruction gaining or losing
+    	// an outgoing edge has its edgesChanged flag set.
+    	std::vector<unsigned> oldEdgeIds(Edges.size(), DFADeletedIndex);
+    	std::vector<bool> edgesChanged(numNodes, false);
+    	for (unsigned edgeId = 0, pos = 0; edgeId < Edges.size() || pos < oldMapped.size();) {
+    		if (pos == oldMapped.size() || (edgeId < Edges.size() && Edges[edgeId] < oldMapped[pos].first)) {
+    			edgesChanged[Edges[edgeId++].first] = true;
+    		} else if (edgeId == Edges.size() || oldMapped[pos].first < Edges[edgeId]) {
+    			edgesChanged[oldMapped[pos++].first.first] = true;
+    		} else {
+    			oldEdgeIds[edgeId++] = oldMapped[pos++].second;
     		}
     	}
+
+    	// Seed the instructions that are new, in a changed block or whose outgoing
+    	// edges changed, then reset everything reachable from them.
+    	std::vector<bool> reset(numNodes, false);
+    	std::vector<unsigned> stack;
+    	auto seed = [&](unsigned idx) {
+    		if (!reset[idx]) {
+    			reset[idx] = true;
+    			stack.push_back(idx);
+    		}
+    	};
+    	// The dummy node is never visited, a new entry instruction is seeded instead.
+    	if (edgesChanged[0])
+    		seed(InstrToIndex[EntryInstr]);
+    	for (unsigned idx = 1; idx < numNodes; ++idx) {
+    		if (edgesChanged[idx] || !hasOld[idx] || ChangedBlocks.count(IndexToInstr[idx]->getParent()))
+    			seed(idx);
+    	}
+    	while (!stack.empty()) {
+    		unsigned idx = stack.back();
+    		stack.pop_back();
+    		for (unsigned edgeId = SuccOffsets[idx]; edgeId < SuccOffsets[idx + 1]; ++edgeId)
+    			seed(Edges[edgeId].second);
+    	}
+
+    	// (1) The edges that are not reset take over their previous information. The
+    	// edge of the dummy node always holds InitialState.
+    	for (unsigned edgeId = 0; edgeId < Edges.size(); ++edgeId) {
+    		if (Edges[edgeId].first == 0 || reset[Edges[edgeId].first])
+    			continue;
+    		assert(oldEdgeIds[edgeId] != DFADeletedIndex && "Kept an edge that did not exist.");
+    		Info *& old = oldInfos[oldEdgeIds[edgeId]];
+    		if (old == &Bottom || old == &InitialState)
+    			continue;
+    		if (!identity)
+    			old->remap(mapping);
+    		EdgeInfos[edgeId] = old;
+    		old = nullptr;
+    	}
+    	for (Info * info : oldInfos) {
+    		if (info)
+    			releaseInfo(info);
+    	}
+    	ChangedBlocks.clear();
+
+    	runWorklist(func, reset);
+
+    	if (DFAVerifyIncremental)
+    		verifyAgainstFullRun(func);
+    }
+
+    /*
+     * Check the current results against a run from scratch on func, which replaces
+     * them. Prints the edges that differ and aborts if there are any.
+     */
+    void verifyAgainstFullRun(Function * func) {
+    	std::vector<Edge> edges(Edges);
+    	std::vector<Info *> infos;
+    	for (Info * info : EdgeInfos)
+    		infos.push_back(allocateInfo(*info));
+    	WorklistStatistics stats = Stats;
+
+    	runWorklistAlgorithm(func);
+    	Stats = stats;
+
+    	bool same = edges == Edges;
+    	if (!same)
+    		errs() << "Incremental update of " << func->getName() << " has different edges than a full run\n";
+    	for (unsigned edgeId = 0; edgeId < Edges.size() && edges == Edges; ++edgeId) {
+    		if (Info::equals(infos[edgeId], EdgeInfos[edgeId]))
+    			continue;
+    		same = false;
+    		errs() << "Incremental update of " << func->getName() << " differs from a full run on edge "
+    		       << Edges[edgeId].first << "->" << Edges[edgeId].second << ":\n";
+    		infos[edgeId]->print();
+    		EdgeInfos[edgeId]->print();
+    	}
+    	for (Info * info : infos)
+    		releaseInfo(info);
+    	if (!same)
+    		report_fatal_error("incremental dataflow update does not match a full run");
+    }
+
+  protected:
+		/*
+		 * Solve the edges from their current information, starting from the
+		 * instructions i with seeds[i] set.
+		 */
+		void runWorklist(Function * func, const std::vector<bool> & seeds) {
+			if (DFAWorklistMode == DFAWorklistKind::InstructionFIFO)
+				runInstructionWorklist(seeds);
+			else
+				runBlockWorklist(func, seeds);
+		}
+
+		/*
+		 * Run the flow function of the instruction identified by index and join the results
+		 * into its outgoing edges. The destinations of the edges that changed are appended
+		 * to ChangedTargets, followed by the instructions the flow function revisits.
+		 */
+		void processInstruction(unsigned index, std::vector<unsigned> & ChangedTargets) {
+			std::vector<unsigned> incomingNode, outgoingNode;
+			getIncomingEdges(index, &incomingNode);
+			getOutgoingEdges(index, &outgoingNode);
+
+			std::vector<Info *> infos;
+			// compute flow function
+			flowfunction(IndexToInstr[index], incomingNode, outgoingNode, infos);
+			Stats.FlowFunctionCalls++;
+
+			for (unsigned i = 0; i < outgoingNode.size(); ++i) {
+				if (joinIntoEdge(SuccOffsets[index] + i, infos[i]))
+					ChangedTargets.push_back(outgoingNode[i]);
+			}
+			ChangedTargets.insert(ChangedTargets.end(), Revisits.begin(), Revisits.end());
+			Revisits.clear();
+
+			std::sort(infos.begin(), infos.end());
+			infos.erase(std::unique(infos.begin(), infos.end()), infos.end());
+			for (Info * info : infos)
+				releaseInfo(info);
+		}
+
+		/*
+		 * FIFO worklist of instructions.
+		 * Every seeded instruction is queued in index order; the destination of an edge
+		 * is queued again whenever the edge changes, and a revisited instruction is queued too.
+		 */
+		void runInstructionWorklist(const std::vector<bool> & seeds) {
+			std::deque<unsigned> worklist;
+
+			// (2) Initialize the work list
+			for (std::map<unsigned, Instruction *>::iterator it=IndexToInstr.begin(); it!=IndexToInstr.end(); ++it){
+				if(it->first == 0 || !seeds[it->first])
+					continue;
+				worklist.push_back(it->first);
+				Stats.WorklistPushes++;
+			}
+
+			// (3) Compute until the work list is empty
+			std::vector<unsigned> changed;
+			while(worklist.size() != 0){
+				unsigned idx = worklist.front();
+				worklist.pop_front();
+				Stats.WorklistPops++;
+
+				changed.clear();
+				processInstruction(idx, changed);
+				for (unsigned target : changed) {
+					worklist.push_back(target);
+					Stats.WorklistPushes++;
+				}
+			}
+		}
+
+		/*
+		 * Priority worklist of basic blocks.
+		 * Blocks are ranked in reverse postorder for forward analyses and in postorder for
+		 * backward ones; blocks unreachable from the entry come last, in layout order.
+		 * Popping a block runs, in analysis order, the flow functions of its instructions
+		 * whose incoming edges changed since their last visit, so straight-line code is
+		 * propagated in one go. A block is only queued again when an edge entering it from
+		 * outside, or from later in the block, changes or when one of its instructions is
+		 * revisited, and at most once at a time.
+		 * Initially only the blocks holding a seeded instruction are queued.
+		 */
+		void runBlockWorklist(Function * func, const std::vector<bool> & seeds) {
+			std::vector<BasicBlock *> order;
+			if (Direction) {
+				ReversePostOrderTraversal<Function *> rpot(func);
+				order.assign(rpot.begin(), rpot.end());
+			} else {
+				for (BasicBlock * block : post_order(func))
+					order.push_back(block);
+			}
+			SmallPtrSet<BasicBlock *, 32> reachable(order.begin(), order.end());
+			for (BasicBlock &block : *func) {
+				if (!reachable.count(&block))
+					order.push_back(&block);
+			}
+
+			// Instructions of a block have consecutive indices: [blockFirst, blockLast].
+			unsigned numNodes = IndexToInstr.size();
+			std::vector<unsigned> rankOfNode(numNodes, 0);
+			std::vector<unsigned> blockFirst(order.size()), blockLast(order.size());
+			for (unsigned rank = 0; rank < order.size(); ++rank) {
+				blockFirst[rank] = InstrToIndex[&order[rank]->front()];
+				blockLast[rank] = InstrToIndex[&order[rank]->back()];
+				for (unsigned idx = blockFirst[rank]; idx <= blockLast[rank]; ++idx)
+					rankOfNode[idx] = rank;
+			}
+
+			// (2) Initialize the work list
+			std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>> worklist;
+			std::vector<bool> inWorklist(order.size(), false);
+			// Instructions whose incoming edges changed since their last visit
+			std::vector<bool> dirty(seeds);
+			for (unsigned rank = 0; rank < order.size(); ++rank) {
+				for (unsigned idx = blockFirst[rank]; idx <= blockLast[rank] && !inWorklist[rank]; ++idx)
+					inWorklist[rank] = seeds[idx];
+				if (!inWorklist[rank])
+					continue;
+				worklist.push(rank);
+				Stats.WorklistPushes++;
+			}
+
+			// (3) Compute until the work list is empty
+			std::vector<unsigned> changed;
+			while (!worklist.empty()) {
+				unsigned rank = worklist.top();
+				worklist.pop();
+				inWorklist[rank] = false;
+				Stats.WorklistPops++;
+
+				unsigned first = blockFirst[rank], last = blockLast[rank];
+				for (unsigned step = 0; step <= last - first; ++step) {
+					unsigned idx = Direction ? first + step : last - step;
+					// Instructions without outgoing edges (phi nodes after the first one,
+					// returns in forward analyses) cannot affect any edge.
+					if (!dirty[idx] || SuccOffsets[idx] == SuccOffsets[idx + 1])
+						continue;
+					dirty[idx] = false;
+
+					changed.clear();
+					processInstruction(idx, changed);
+					for (unsigned target : changed) {
+						dirty[target] = true;
+						unsigned targetRank = rankOfNode[target];
+						bool laterInBlock = targetRank == rank && (Direction ? target > idx : target < idx);
+						if (laterInBlock || inWorklist[targetRank])
+							continue;
+						worklist.push(targetRank);
+						inWorklist[targetRank] = true;
+						Stats.WorklistPushes++;
+					}
+				}
+			}
+		}
+
+		WorklistStatistics Stats;
+
+  public:
+    const WorklistStatistics & getStatistics() const {
+    	return Stats;
+    }
+
+    const InfoPool<Info> & getPool() const {
+    	return Pool;
+    }
+
+    /*
+     * Print the worklist and memory statistics of the analysis to errs().
+     */
+    void printStatistics() {
+    	errs() << "Flow function invocations: " << Stats.FlowFunctionCalls << "\n";
+    	errs() << "Worklist pushes: " << Stats.WorklistPushes << "\n";
+    	errs() << "Worklist pops: " << Stats.WorklistPops << "\n";
+    	errs() << "Joins: " << Stats.Joins << "\n";
+    	Pool.printStatistics(errs());
     }
 };
 
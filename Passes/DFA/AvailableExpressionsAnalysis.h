@@ -0,0 +1,173 @@
+//===- AvailableExpressionsAnalysis.h - Available expressions for CSE 231 DFA -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the lattice and the flow function of a forward must
+// analysis of the pure expressions computed on every path to a point, which
+// tells the instructions that recompute one of them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_AVAILABLEEXPRESSIONSANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_AVAILABLEEXPRESSIONSANALYSIS_H
+
+#include "231DFA.h"
+#include "IndexSetInfo.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/Instructions.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+class AvailableExpressionsInfo : public IntersectionSetInfo<AvailableExpressionsInfo> {
+public:
+	AvailableExpressionsInfo() {}
+	AvailableExpressionsInfo(unsigned index) : IntersectionSetInfo<AvailableExpressionsInfo>(index) {}
+	AvailableExpressionsInfo(const AvailableExpressionsInfo& other) : IntersectionSetInfo<AvailableExpressionsInfo>(other) {}
+};
+
+/*
+ * The expression an instruction computes: its opcode, type and predicate, and
+ * its operands. An operand that is an instruction is its index in InstrToIndex,
+ * any other value (constant, argument) is itself. The operands of commutative
+ * operators are sorted.
+ */
+struct ExpressionKey {
+	typedef std::pair<unsigned, Value *> Operand;
+
+	unsigned Opcode;
+	Type * ResultType;
+	unsigned Predicate;
+	SmallVector<Operand, 3> Operands;
+
+	bool operator<(const ExpressionKey &other) const {
+		return std::tie(Opcode, ResultType, Predicate, Operands) <
+		       std::tie(other.Opcode, other.ResultType, other.Predicate, other.Operands);
+	}
+};
+
+/*
+ * The information after an instruction holds the index of every pure
+ * expression instruction run on all paths from the entry to there. In SSA the
+ * operands of an instruction never change, so nothing is killed: an index is
+ * only dropped by the intersection at a join. An instruction available before
+ * another dominates it, so an available instruction computing the same
+ * expression can stand for the other one.
+ *
+ * The bottom is the universe and the initial state is empty. Arithmetic,
+ * casts, comparisons, selects and getelementptr are pure expressions: they
+ * neither touch memory nor have side effects.
+ */
+template <class Info, bool Direction>
+class AvailableExpressionsAnalysis : public DataFlowAnalysis<Info, Direction> {
+public:
+	AvailableExpressionsAnalysis(AvailableExpressionsInfo &bottom, AvailableExpressionsInfo &initialState) :
+		DataFlowAnalysis<Info, Direction>::DataFlowAnalysis(bottom, initialState), Ready(false) {}
+
+	/*
+	 * The expressions refer to instruction indices: they are rebuilt after
+	 * numbering.
+	 */
+	void runWorklistAlgorithm(Function * func) {
+		reset();
+		DataFlowAnalysis<Info, Direction>::runWorklistAlgorithm(func);
+	}
+
+	void updateWorklistAlgorithm(Function * func) {
+		reset();
+		DataFlowAnalysis<Info, Direction>::updateWorklistAlgorithm(func);
+	}
+
+	static bool isExpression(Instruction * I) {
+		return isa<BinaryOperator>(I) || isa<CastInst>(I) || isa<CmpInst>(I) ||
+		       isa<SelectInst>(I) || isa<GetElementPtrInst>(I);
+	}
+
+	void flowfunction(Instruction * I,
+    									std::vector<unsigned> & IncomingEdges,
+										std::vector<unsigned> & OutgoingEdges,
+										std::vector<Info *> & Infos) {
+
+		unsigned idx = this->InstrToIndex[I];
+		Info *combineInfo = this->joinIncoming(idx);
+		if (isExpression(I))
+			combineInfo->insert(idx);
+		this->shareOutgoingInfo(combineInfo, OutgoingEdges.size(), Infos);
+	}
+
+	/*
+	 * An instruction computing the same expression as I that is available
+	 * before I, or nullptr. Code no path from the entry reaches has none.
+	 */
+	Instruction * getAvailableExpression(Instruction * I) {
+		if (!isExpression(I))
+			return nullptr;
+		build();
+		unsigned idx = this->getIndexOf(I);
+		bool reached = this->anyIncomingInfo(I, [](const Info &info) {
+			return !info.isUniverse();
+		});
+		if (idx == 0 || !reached)
+			return nullptr;
+		for (unsigned other : Expressions[getKey(I)]) {
+			if (other == idx)
+				continue;
+			bool killed = this->anyIncomingInfo(I, [&](const Info &info) {
+				return !info.contains(other);
+			});
+			if (!killed)
+				return this->getInstrOf(other);
+		}
+		return nullptr;
+	}
+
+private:
+	bool Ready;
+	// Instructions computing each expression, in increasing index order
+	std::map<ExpressionKey, SmallVector<unsigned, 2>> Expressions;
+
+	void reset() {
+		Ready = false;
+		Expressions.clear();
+	}
+
+	void build() {
+		if (Ready)
+			return;
+		Ready = true;
+		for (auto &entry : this->IndexToInstr) {
+			if (entry.second && isExpression(entry.second))
+				Expressions[getKey(entry.second)].push_back(entry.first);
+		}
+	}
+
+	ExpressionKey getKey(Instruction * I) {
+		ExpressionKey key;
+		key.Opcode = I->getOpcode();
+		key.ResultType = I->getType();
+		key.Predicate = isa<CmpInst>(I) ? (unsigned)cast<CmpInst>(I)->getPredicate() : 0;
+		for (Value * operand : I->operands()) {
+			Instruction * operandInstr = dyn_cast<Instruction>(operand);
+			if (operandInstr)
+				key.Operands.push_back(std::make_pair(this->getIndexOf(operandInstr), nullptr));
+			else
+				key.Operands.push_back(std::make_pair(0u, operand));
+		}
+		if (I->isCommutative())
+			std::sort(key.Operands.begin(), key.Operands.end());
+		return key;
+	}
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_AVAILABLEEXPRESSIONSANALYSIS_H
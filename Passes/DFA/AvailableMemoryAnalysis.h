@@ -0,0 +1,298 @@
+//===- AvailableMemoryAnalysis.h - Available memory values for CSE 231 DFA -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the lattice and the flow function of a forward analysis
+// of the values known to be in memory: a load is redundant if the value it
+// reads was stored or loaded through the same pointer on every path to it,
+// with nothing in between that may have written there.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_AVAILABLEMEMORYANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_AVAILABLEMEMORYANALYSIS_H
+
+#include "231DFA.h"
+#include "DFAAliasAnalysis.h"
+#include "IndexSetInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace llvm {
+
+class AvailableMemoryInfo : public IndexSetInfo<AvailableMemoryInfo> {
+public:
+	AvailableMemoryInfo() {}
+	AvailableMemoryInfo(unsigned index) : IndexSetInfo<AvailableMemoryInfo>(index) {}
+	AvailableMemoryInfo(const AvailableMemoryInfo& other) : IndexSetInfo<AvailableMemoryInfo>(other) {}
+};
+
+/*
+ * The memory operations are the simple loads and stores. One is available at a
+ * point if every path from the entry runs it and then nothing that may write to
+ * its memory: the memory still holds the value it loaded or stored.
+ *
+ * Availability is a must property, so the information holds the complement:
+ * the operations that are NOT available. The union join of the framework then
+ * intersects the available ones, and bottom, the empty set, is the optimistic
+ * start a loop needs. Nothing is available on entry.
+ *
+ * Pointers are resolved with an EscapePointsTo solved on the same function. A
+ * pointer to Unknown may write to every escaped alloca, and so may any call
+ * that writes to memory.
+ */
+template <class Info, bool Direction>
+class AvailableMemoryAnalysis : public DataFlowAnalysis<Info, Direction> {
+public:
+	AvailableMemoryAnalysis(AvailableMemoryInfo &bottom, AvailableMemoryInfo &initialState, EscapePointsTo &pointsTo) :
+		DataFlowAnalysis<Info, Direction>::DataFlowAnalysis(bottom, initialState), PointsTo(pointsTo), Ready(false) {}
+
+	/*
+	 * The memory operations and the sets of what each instruction overwrites
+	 * use the indices of the instructions: they are rebuilt after numbering.
+	 */
+	void runWorklistAlgorithm(Function * func) {
+		reset();
+		DataFlowAnalysis<Info, Direction>::runWorklistAlgorithm(func);
+	}
+
+	void updateWorklistAlgorithm(Function * func) {
+		reset();
+		DataFlowAnalysis<Info, Direction>::updateWorklistAlgorithm(func);
+	}
+
+	/*
+	 * The effect of I on the set of operations that are not available after it.
+	 */
+	void transfer(Instruction * I, Info * info) {
+		build();
+		unsigned idx = this->InstrToIndex[I];
+		if (I == this->EntryInstr) {
+			for (unsigned operation : Operations)
+				info->insert(operation);
+		}
+		auto kills = Kills.find(idx);
+		if (kills == Kills.end())
+			kills = Kills.insert(std::make_pair(idx, computeKills(I))).first;
+		Info::joinInto(info, &kills->second);
+		if (Locations.count(idx))
+			info->remove(idx);
+	}
+
+	void flowfunction(Instruction * I,
+    									std::vector<unsigned> & IncomingEdges,
+										std::vector<unsigned> & OutgoingEdges,
+										std::vector<Info *> & Infos) {
+
+		unsigned idx = this->InstrToIndex[I];
+		Info *combineInfo = this->joinIncoming(idx);
+		transfer(I, combineInfo);
+		this->shareOutgoingInfo(combineInfo, OutgoingEdges.size(), Infos);
+	}
+
+	/*
+	 * A load or store through the pointer of load, of the type it loads, that
+	 * is available before it, or nullptr. The value it loaded or stored is the
+	 * one load would read, and its definition dominates load.
+	 */
+	Instruction * getAvailableOperation(LoadInst * load) {
+		build();
+		unsigned idx = this->getIndexOf(load);
+		// The edge into the entry instruction holds bottom, not every operation
+		if (!Locations.count(idx) || load == this->EntryInstr)
+			return nullptr;
+		auto sameMemory = ByPointer.find(load->getPointerOperand());
+		if (sameMemory == ByPointer.end())
+			return nullptr;
+		for (unsigned operation : sameMemory->second) {
+			if (operation == idx)
+				continue;
+			Instruction * I = this->getInstrOf(operation);
+			Type * type = isa<StoreInst>(I) ? cast<StoreInst>(I)->getValueOperand()->getType() : I->getType();
+			if (type != load->getType())
+				continue;
+			bool killed = this->anyIncomingInfo(load, [&](const Info &info) {
+				return info.getInfo().contains(operation);
+			});
+			if (!killed)
+				return I;
+		}
+		return nullptr;
+	}
+
+private:
+	struct Location {
+		SmallVector<unsigned, 4> Objects;
+		bool Unknown;
+		// False for the pointers the solver has not seen
+		bool Valid;
+	};
+
+	EscapePointsTo &PointsTo;
+	bool Ready;
+	// Indices of the memory operations, in increasing order
+	std::vector<unsigned> Operations;
+	// Location of each memory operation
+	DenseMap<unsigned, Location> Locations;
+	// Memory operations through each pointer
+	DenseMap<Value *, SmallVector<unsigned, 2>> ByPointer;
+	// Memory operations each instruction visited so far may overwrite
+	std::map<unsigned, Info> Kills;
+
+	void reset() {
+		Ready = false;
+		Operations.clear();
+		Locations.clear();
+		ByPointer.clear();
+		Kills.clear();
+	}
+
+	void build() {
+		if (Ready)
+			return;
+		Ready = true;
+		for (auto &entry : this->IndexToInstr) {
+			Instruction * I = entry.second;
+			Value * pointer = nullptr;
+			if (LoadInst * load = dyn_cast_or_null<LoadInst>(I)) {
+				if (load->isSimple())
+					pointer = load->getPointerOperand();
+			} else if (StoreInst * store = dyn_cast_or_null<StoreInst>(I)) {
+				if (store->isSimple())
+					pointer = store->getPointerOperand();
+			}
+			if (!pointer)
+				continue;
+			Operations.push_back(entry.first);
+			Locations[entry.first] = getLocation(pointer);
+			ByPointer[pointer].push_back(entry.first);
+		}
+	}
+
+	Location getLocation(Value * pointer) {
+		Location location;
+		location.Valid = PointsTo.getObjects(pointer, location.Objects, location.Unknown);
+		return location;
+	}
+
+	/*
+	 * Whether writing to a may change what is read from b: they may point to the
+	 * same alloca, or one may point to Unknown and the other to Unknown or to an
+	 * escaped alloca. Pointers with no pointee are null, undefined or in
+	 * unreachable code, and are kept apart from nothing.
+	 */
+	bool mayOverlap(const Location &a, const Location &b) {
+		if (!a.Valid || !b.Valid || (a.Objects.empty() && !a.Unknown) || (b.Objects.empty() && !b.Unknown))
+			return true;
+		if (a.Unknown && b.Unknown)
+			return true;
+		auto ita = a.Objects.begin(), itb = b.Objects.begin();
+		while (ita != a.Objects.end() && itb != b.Objects.end()) {
+			if (*ita == *itb)
+				return true;
+			if (*ita < *itb)
+				++ita;
+			else
+				++itb;
+		}
+		if (a.Unknown || b.Unknown)
+			return mayBeEscaped(a.Unknown ? b : a);
+		return false;
+	}
+
+	bool mayBeEscaped(const Location &location) {
+		if (!location.Valid || location.Unknown || location.Objects.empty())
+			return true;
+		for (unsigned object : location.Objects) {
+			if (PointsTo.isEscaped(object))
+				return true;
+		}
+		return false;
+	}
+
+	/*
+	 * The memory operations I may overwrite.
+	 */
+	Info computeKills(Instruction * I) {
+		Info kills;
+		switch (I->getOpcode()) {
+		case Instruction::Load:
+			if (cast<LoadInst>(I)->isSimple())
+				break;
+			addAll(kills);
+			break;
+		case Instruction::Store:
+			addOverlapping(getLocation(cast<StoreInst>(I)->getPointerOperand()), kills);
+			break;
+		case Instruction::Call:
+			addCallKills(cast<CallInst>(I), kills);
+			break;
+		case Instruction::Invoke:
+			addCallKills(cast<InvokeInst>(I), kills);
+			break;
+		default:
+			if (I->mayWriteToMemory())
+				addAll(kills);
+			break;
+		}
+		return kills;
+	}
+
+	void addAll(Info &kills) {
+		for (unsigned operation : Operations)
+			kills.insert(operation);
+	}
+
+	void addOverlapping(const Location &written, Info &kills) {
+		for (unsigned operation : Operations) {
+			if (mayOverlap(written, Locations[operation]))
+				kills.insert(operation);
+		}
+	}
+
+	/*
+	 * A call may write to the escaped allocas, which include the ones its
+	 * arguments point to, except for the intrinsics that write nothing or only
+	 * their destination. Lifetime markers leave their memory undefined.
+	 */
+	template <class CallT>
+	void addCallKills(CallT * call, Info &kills) {
+		if (IntrinsicInst * intrinsic = dyn_cast<IntrinsicInst>(call)) {
+			switch (intrinsic->getIntrinsicID()) {
+			case Intrinsic::dbg_declare:
+			case Intrinsic::dbg_value:
+				return;
+			case Intrinsic::lifetime_start:
+			case Intrinsic::lifetime_end:
+				addOverlapping(getLocation(intrinsic->getArgOperand(1)), kills);
+				return;
+			case Intrinsic::memset:
+			case Intrinsic::memcpy:
+			case Intrinsic::memmove:
+				addOverlapping(getLocation(cast<MemIntrinsic>(intrinsic)->getRawDest()), kills);
+				return;
+			default:
+				break;
+			}
+		}
+		if (call->onlyReadsMemory())
+			return;
+		for (unsigned operation : Operations) {
+			if (mayBeEscaped(Locations[operation]))
+				kills.insert(operation);
+		}
+	}
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_AVAILABLEMEMORYANALYSIS_H
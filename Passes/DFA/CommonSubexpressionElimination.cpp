@@ -0,0 +1,92 @@
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "231DFA.h"
+#include "AvailableExpressionsAnalysis.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+/*
+ * Replaces every instruction that recomputes an available expression by the
+ * instruction computing it first. That instruction dominates the one it
+ * replaces, and keeps only the flags (nsw, nuw, exact, inbounds, fast-math)
+ * both of them have, so it cannot be poison where the replaced one was not.
+ * Replacing operands makes more instructions compute the same expression, so
+ * this goes on in rounds, with the analysis brought up to date incrementally,
+ * until none is found.
+ */
+struct CommonSubexpressionEliminationPass : public FunctionPass {
+ 	static char ID;
+  	CommonSubexpressionEliminationPass() : FunctionPass(ID) {}
+
+  	bool runOnFunction(Function &F) override {
+  		AvailableExpressionsInfo bottom = AvailableExpressionsInfo::universe();
+  		AvailableExpressionsInfo initialState;
+  		AvailableExpressionsAnalysis<AvailableExpressionsInfo, true> available(bottom, initialState);
+  		available.runWorklistAlgorithm(&F);
+
+  		unsigned eliminated = 0;
+  		unsigned rounds = 0;
+  		while (true) {
+  			++rounds;
+  			// Instruction each removed one was replaced with
+  			DenseMap<Instruction *, Instruction *> replaced;
+  			std::vector<Instruction *> dead;
+  			for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+  				Instruction * source = available.getAvailableExpression(&*I);
+  				if (!source)
+  					continue;
+  				source = resolve(replaced, source);
+  				source->andIRFlags(&*I);
+  				if (GetElementPtrInst * gep = dyn_cast<GetElementPtrInst>(source))
+  					gep->setIsInBounds(gep->isInBounds() && cast<GetElementPtrInst>(&*I)->isInBounds());
+  				replaced[&*I] = source;
+  				dead.push_back(&*I);
+  			}
+  			if (dead.empty())
+  				break;
+
+  			// The users now compute the expressions of the replacements, which
+  			// other instructions may recompute in the next round
+  			for (Instruction * I : dead) {
+  				available.invalidateInstruction(I);
+  				for (User * user : I->users())
+  					available.invalidateInstruction(cast<Instruction>(user));
+  				I->replaceAllUsesWith(resolve(replaced, I));
+  			}
+  			for (Instruction * I : dead)
+  				I->eraseFromParent();
+  			eliminated += dead.size();
+  			available.updateWorklistAlgorithm(&F);
+  		}
+
+  		errs() << "Function " << F.getName() << ": eliminated " << eliminated << " common subexpressions in "
+  		       << rounds << " rounds\n";
+  		if (DFAPrintStatistics)
+  			available.printStatistics();
+
+  		return eliminated != 0;
+  	}
+
+  private:
+  	/*
+  	 * The instruction that stands for I once the replacements are done. An
+  	 * instruction may be replaced by one that comes later in the function and
+  	 * is replaced itself.
+  	 */
+  	static Instruction * resolve(DenseMap<Instruction *, Instruction *> &replaced, Instruction * I) {
+  		for (auto it = replaced.find(I); it != replaced.end(); it = replaced.find(I))
+  			I = it->second;
+  		return I;
+  	}
+}; // end of struct
+}  // end of anonymous namespace
+
+char CommonSubexpressionEliminationPass::ID = 0;
+static RegisterPass<CommonSubexpressionEliminationPass> X("cse231-gcse", "global common subexpression elimination",
+                             false /* Only looks at CFG */,
+                             false /* Analysis Pass */);
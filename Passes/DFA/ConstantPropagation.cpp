@@ -0,0 +1,90 @@
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Pass.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "231DFA.h"
+#include "ConstantPropagationAnalysis.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+/*
+ * Replaces the instructions of executable blocks whose value is a constant by
+ * that constant, folds the branches on the constants, and deletes the blocks
+ * no longer reachable from the entry.
+ */
+struct ConstantPropagationPass : public FunctionPass {
+ 	static char ID;
+  	ConstantPropagationPass() : FunctionPass(ID) {}
+
+  	bool runOnFunction(Function &F) override {
+  		ExecutableInfo bottom;
+  		ExecutableInfo initialState(true);
+  		ConstantPropagationAnalysis<ExecutableInfo, true> constants(bottom, initialState);
+  		constants.runWorklistAlgorithm(&F);
+
+  		std::vector<BasicBlock *> executable;
+  		for (BasicBlock &block : F) {
+  			if (constants.isExecutable(&block))
+  				executable.push_back(&block);
+  		}
+
+  		unsigned foldedInstructions = 0;
+  		std::vector<Instruction *> folded;
+  		for (BasicBlock * block : executable) {
+  			for (Instruction &I : *block) {
+  				if (Constant * C = constants.getConstant(&I)) {
+  					I.replaceAllUsesWith(C);
+  					folded.push_back(&I);
+  				}
+  			}
+  		}
+  		for (Instruction * I : folded) {
+  			I->eraseFromParent();
+  			++foldedInstructions;
+  		}
+
+  		unsigned foldedBranches = 0;
+  		for (BasicBlock * block : executable) {
+  			if (ConstantFoldTerminator(block))
+  				++foldedBranches;
+  		}
+
+  		// A block the analysis found unreachable may still have an edge from a
+  		// branch whose condition stayed undefined, so only the CFG decides
+  		SmallPtrSet<BasicBlock *, 32> reachable;
+  		for (BasicBlock * block : depth_first(&F.getEntryBlock()))
+  			reachable.insert(block);
+  		std::vector<BasicBlock *> dead;
+  		for (BasicBlock &block : F) {
+  			if (reachable.count(&block))
+  				continue;
+  			for (BasicBlock * succ : successors(&block)) {
+  				if (reachable.count(succ))
+  					succ->removePredecessor(&block);
+  			}
+  			block.dropAllReferences();
+  			dead.push_back(&block);
+  		}
+  		for (BasicBlock * block : dead)
+  			block->eraseFromParent();
+
+  		errs() << "Function " << F.getName() << ": folded " << foldedInstructions << " instructions and "
+  		       << foldedBranches << " branches, removed " << dead.size() << " unreachable blocks\n";
+  		if (DFAPrintStatistics)
+  			constants.printStatistics();
+
+  		return foldedInstructions + foldedBranches + dead.size() != 0;
+  	}
+}; // end of struct
+}  // end of anonymous namespace
+
+char ConstantPropagationPass::ID = 0;
+static RegisterPass<ConstantPropagationPass> X("cse231-sccp", "sparse conditional constant propagation",
+                             false /* Only looks at CFG */,
+                             false /* Analysis Pass */);
@@ -0,0 +1,315 @@
+//===- ConstantPropagationAnalysis.h - Sparse conditional constants for CSE 231 DFA -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides sparse conditional constant propagation on the dataflow
+// framework: the edges only tell whether they may be executed, and the
+// constant lattice of every SSA value is kept by the analysis, which revisits
+// the users of a value when it changes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_CONSTANTPROPAGATIONANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_CONSTANTPROPAGATIONANALYSIS_H
+
+#include "231DFA.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Whether an edge may be executed. Bottom is false and the join is or.
+ */
+class ExecutableInfo : public Info {
+public:
+	ExecutableInfo() : Executable(false) {}
+	ExecutableInfo(bool executable) : Executable(executable) {}
+	ExecutableInfo(const ExecutableInfo& other) : Info(other), Executable(other.Executable) {}
+
+	void print() {
+		errs() << (Executable ? "executable" : "unreachable") << "\n";
+	}
+
+	static bool equals(Info * info1, Info * info2) {
+		return ((ExecutableInfo *)info1)->Executable == ((ExecutableInfo *)info2)->Executable;
+	}
+
+	static bool joinInto(Info * dst, Info * src) {
+		ExecutableInfo * d = (ExecutableInfo *)dst;
+		if (d->Executable || !((ExecutableInfo *)src)->Executable)
+			return false;
+		d->Executable = true;
+		return true;
+	}
+
+	void remap(const DFAIndexRemapping &) {}
+
+	bool isExecutable() const {
+		return Executable;
+	}
+
+private:
+	bool Executable;
+};
+
+/*
+ * The three levels of the lattice of an SSA value: undefined until an
+ * executable definition is evaluated, then a single constant, then overdefined.
+ */
+struct ConstantLatticeValue {
+	enum State { Undefined, SingleConstant, Overdefined };
+
+	State Kind;
+	Constant * Const;
+
+	ConstantLatticeValue() : Kind(Undefined), Const(nullptr) {}
+
+	static ConstantLatticeValue constant(Constant * C) {
+		ConstantLatticeValue value;
+		value.Kind = SingleConstant;
+		value.Const = C;
+		return value;
+	}
+
+	static ConstantLatticeValue overdefined() {
+		ConstantLatticeValue value;
+		value.Kind = Overdefined;
+		return value;
+	}
+
+	/*
+	 * Meet other into this value. Returns true if it changed.
+	 */
+	bool mergeIn(const ConstantLatticeValue &other) {
+		if (Kind == Overdefined || other.Kind == Undefined)
+			return false;
+		if (Kind == Undefined) {
+			*this = other;
+			return true;
+		}
+		if (other.Kind == SingleConstant && other.Const == Const)
+			return false;
+		*this = overdefined();
+		return true;
+	}
+};
+
+/*
+ * Wegman and Zadeck's conditional constant propagation. The initial state is
+ * executable, so the edges reached from the entry through feasible branches
+ * are, and the flow function of an executable instruction evaluates it over
+ * the lattice values of its operands. A terminator then marks the successors
+ * its condition may select.
+ *
+ * The phi nodes of a block only have edges at the first one, whose flow
+ * function evaluates all of them over the executable incoming edges. Arguments,
+ * undef and the results of loads, calls and the like are overdefined.
+ */
+template <class Info, bool Direction>
+class ConstantPropagationAnalysis : public DataFlowAnalysis<Info, Direction> {
+public:
+	ConstantPropagationAnalysis(ExecutableInfo &bottom, ExecutableInfo &initialState) :
+		DataFlowAnalysis<Info, Direction>::DataFlowAnalysis(bottom, initialState) {}
+
+	void runWorklistAlgorithm(Function * func) {
+		Values.clear();
+		DataFlowAnalysis<Info, Direction>::runWorklistAlgorithm(func);
+	}
+
+	/*
+	 * The lattice values are indexed by instruction and live outside the
+	 * edges, so an update starts over.
+	 */
+	void updateWorklistAlgorithm(Function * func) {
+		runWorklistAlgorithm(func);
+	}
+
+	void flowfunction(Instruction * I,
+    									std::vector<unsigned> & IncomingEdges,
+										std::vector<unsigned> & OutgoingEdges,
+										std::vector<Info *> & Infos) {
+
+		if (Values.empty())
+			Values.resize(this->IndexToInstr.size());
+		unsigned idx = this->InstrToIndex[I];
+		Info *combineInfo = this->joinIncoming(idx);
+		if (combineInfo->isExecutable())
+			visit(I);
+		if (!combineInfo->isExecutable() || !I->isTerminator()) {
+			this->shareOutgoingInfo(combineInfo, OutgoingEdges.size(), Infos);
+			return;
+		}
+
+		// A terminator with a value, such as an invoke, was evaluated above
+		SmallVector<unsigned, 2> feasible;
+		getFeasibleSuccessors(I, feasible);
+		Info * executable = nullptr;
+		Info * unreachable = nullptr;
+		for (unsigned dst : OutgoingEdges) {
+			bool isFeasible = std::find(feasible.begin(), feasible.end(), dst) != feasible.end();
+			Info *& info = isFeasible ? executable : unreachable;
+			if (!info)
+				info = this->allocateInfo(isFeasible);
+			Infos.push_back(info);
+		}
+		this->releaseInfo(combineInfo);
+	}
+
+	/*
+	 * Whether some executable edge enters block.
+	 */
+	bool isExecutable(BasicBlock * block) {
+		return this->anyIncomingInfo(&block->front(), [](const Info &info) {
+			return info.isExecutable();
+		});
+	}
+
+	ConstantLatticeValue getValue(Value * V) {
+		if (Instruction * I = dyn_cast<Instruction>(V)) {
+			unsigned idx = this->getIndexOf(I);
+			if (idx == 0 || idx >= Values.size())
+				return ConstantLatticeValue::overdefined();
+			return Values[idx];
+		}
+		if (Constant * C = dyn_cast<Constant>(V)) {
+			if (!isa<UndefValue>(C))
+				return ConstantLatticeValue::constant(C);
+		}
+		return ConstantLatticeValue::overdefined();
+	}
+
+	/*
+	 * The constant V always holds, or nullptr.
+	 */
+	Constant * getConstant(Value * V) {
+		ConstantLatticeValue value = getValue(V);
+		return value.Kind == ConstantLatticeValue::SingleConstant ? value.Const : nullptr;
+	}
+
+private:
+	// Lattice value of each instruction, by index
+	std::vector<ConstantLatticeValue> Values;
+
+	void visit(Instruction * I) {
+		if (isa<PHINode>(I)) {
+			for (auto it = I->getParent()->begin(); PHINode * phi = dyn_cast<PHINode>(&*it); ++it)
+				update(phi, evaluatePhi(phi));
+			return;
+		}
+		if (I->getType()->isVoidTy())
+			return;
+		update(I, evaluate(I));
+	}
+
+	/*
+	 * Merge value into the lattice value of I, revisiting the users of I if it
+	 * changed. The users that are phi nodes are revisited at their first one.
+	 */
+	void update(Instruction * I, const ConstantLatticeValue &value) {
+		if (!Values[this->InstrToIndex[I]].mergeIn(value))
+			return;
+		for (User * user : I->users()) {
+			Instruction * userInstr = cast<Instruction>(user);
+			if (isa<PHINode>(userInstr))
+				userInstr = &userInstr->getParent()->front();
+			if (unsigned userIdx = this->getIndexOf(userInstr))
+				this->revisit(userIdx);
+		}
+	}
+
+	ConstantLatticeValue evaluatePhi(PHINode * phi) {
+		unsigned dst = this->InstrToIndex[&phi->getParent()->front()];
+		ConstantLatticeValue result;
+		for (unsigned i = 0; i < phi->getNumIncomingValues(); ++i) {
+			unsigned src = this->getIndexOf(phi->getIncomingBlock(i)->getTerminator());
+			if (src == 0 || !this->EdgeInfos[this->getEdgeId(src, dst)]->isExecutable())
+				continue;
+			result.mergeIn(getValue(phi->getIncomingValue(i)));
+		}
+		return result;
+	}
+
+	ConstantLatticeValue evaluate(Instruction * I) {
+		if (SelectInst * select = dyn_cast<SelectInst>(I)) {
+			ConstantLatticeValue condition = getValue(select->getCondition());
+			if (condition.Kind == ConstantLatticeValue::Undefined)
+				return condition;
+			if (condition.Kind == ConstantLatticeValue::SingleConstant) {
+				if (condition.Const->isOneValue())
+					return getValue(select->getTrueValue());
+				if (condition.Const->isNullValue())
+					return getValue(select->getFalseValue());
+			}
+			ConstantLatticeValue result = getValue(select->getTrueValue());
+			result.mergeIn(getValue(select->getFalseValue()));
+			return result;
+		}
+		if (!isa<BinaryOperator>(I) && !isa<CastInst>(I) && !isa<CmpInst>(I) && !isa<GetElementPtrInst>(I))
+			return ConstantLatticeValue::overdefined();
+
+		// An undefined operand leaves the result undefined until it is evaluated,
+		// an overdefined one makes it overdefined
+		SmallVector<Constant *, 4> operands;
+		bool undefined = false;
+		for (Value * operand : I->operands()) {
+			ConstantLatticeValue value = getValue(operand);
+			if (value.Kind == ConstantLatticeValue::Overdefined)
+				return value;
+			undefined = undefined || value.Kind == ConstantLatticeValue::Undefined;
+			operands.push_back(value.Const);
+		}
+		if (undefined)
+			return ConstantLatticeValue();
+		const DataLayout &DL = I->getModule()->getDataLayout();
+		Constant * folded;
+		if (CmpInst * cmp = dyn_cast<CmpInst>(I))
+			folded = ConstantFoldCompareInstOperands(cmp->getPredicate(), operands[0], operands[1], DL);
+		else
+			folded = ConstantFoldInstOperands(I, operands, DL);
+		if (!folded || isa<UndefValue>(folded))
+			return ConstantLatticeValue::overdefined();
+		return ConstantLatticeValue::constant(folded);
+	}
+
+	/*
+	 * The indices of the first instructions of the successors terminator may
+	 * branch to.
+	 */
+	void getFeasibleSuccessors(Instruction * terminator, SmallVectorImpl<unsigned> &feasible) {
+		BasicBlock * only = nullptr;
+		if (BranchInst * branch = dyn_cast<BranchInst>(terminator)) {
+			if (branch->isConditional()) {
+				ConstantLatticeValue condition = getValue(branch->getCondition());
+				if (condition.Kind == ConstantLatticeValue::Undefined)
+					return;
+				if (ConstantInt * C = dyn_cast_or_null<ConstantInt>(condition.Const))
+					only = branch->getSuccessor(C->isZero() ? 1 : 0);
+			}
+		} else if (SwitchInst * sw = dyn_cast<SwitchInst>(terminator)) {
+			ConstantLatticeValue condition = getValue(sw->getCondition());
+			if (condition.Kind == ConstantLatticeValue::Undefined)
+				return;
+			if (ConstantInt * C = dyn_cast_or_null<ConstantInt>(condition.Const))
+				only = sw->findCaseValue(C)->getCaseSuccessor();
+		}
+		if (only) {
+			feasible.push_back(this->InstrToIndex[&only->front()]);
+			return;
+		}
+		for (unsigned i = 0; i < terminator->getNumSuccessors(); ++i)
+			feasible.push_back(this->InstrToIndex[&terminator->getSuccessor(i)->front()]);
+	}
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_CONSTANTPROPAGATIONANALYSIS_H
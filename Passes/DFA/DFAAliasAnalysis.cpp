@@ -0,0 +1,163 @@
+//===- DFAAliasAnalysis.cpp - Alias analysis on the CSE 231 DFA points-to sets ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the alias analysis declared in DFAAliasAnalysis.h and
+// registers its legacy pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DFAAliasAnalysis.h"
+#include "llvm/IR/InstIterator.h"
+
+using namespace llvm;
+
+DFAAAResult::DFAAAResult() : AAResultBase() {}
+
+DFAAAResult::DFAAAResult(DFAAAResult &&other) :
+	AAResultBase(std::move(other)), Functions(std::move(other.Functions)) {}
+
+DFAAAResult::~DFAAAResult() {}
+
+/*
+ * Two pointers may alias if they may point to the same alloca, or if both may
+ * point to Unknown, or if one may point to Unknown and the other to an escaped
+ * alloca. Pointers with no pointee are left to the other analyses: they are
+ * null, undefined or in unreachable code.
+ */
+AliasResult DFAAAResult::alias(const MemoryLocation &LocA, const MemoryLocation &LocB) {
+	Function * F = getParentFunction(LocA.Ptr);
+	Function * G = getParentFunction(LocB.Ptr);
+	if (!F)
+		F = G;
+	if (!F || (G && G != F))
+		return AAResultBase::alias(LocA, LocB);
+
+	FunctionInfo &info = getFunctionInfo(F);
+	// Look b up first: looking a up again cannot insert, so b stays valid
+	getPointerObjects(info, LocA.Ptr);
+	const PointerObjects &b = getPointerObjects(info, LocB.Ptr);
+	const PointerObjects &a = getPointerObjects(info, LocA.Ptr);
+	if (!a.Valid || !b.Valid || (a.Objects.empty() && !a.Unknown) || (b.Objects.empty() && !b.Unknown))
+		return AAResultBase::alias(LocA, LocB);
+	if (a.Unknown && b.Unknown)
+		return AAResultBase::alias(LocA, LocB);
+
+	auto ita = a.Objects.begin(), itb = b.Objects.begin();
+	while (ita != a.Objects.end() && itb != b.Objects.end()) {
+		if (*ita == *itb)
+			return AAResultBase::alias(LocA, LocB);
+		if (*ita < *itb)
+			++ita;
+		else
+			++itb;
+	}
+	const PointerObjects &known = a.Unknown ? b : a;
+	if (a.Unknown || b.Unknown) {
+		for (unsigned object : known.Objects) {
+			if (info.Solver.isEscaped(object))
+				return AAResultBase::alias(LocA, LocB);
+		}
+	}
+	return NoAlias;
+}
+
+/*
+ * A call can only reach the allocas that escape and those its arguments point
+ * to.
+ */
+ModRefInfo DFAAAResult::getModRefInfo(ImmutableCallSite CS, const MemoryLocation &Loc) {
+	Function * F = const_cast<Function *>(CS.getInstruction()->getFunction());
+	if (getParentFunction(Loc.Ptr) != F)
+		return AAResultBase::getModRefInfo(CS, Loc);
+
+	FunctionInfo &info = getFunctionInfo(F);
+	const PointerObjects loc = getPointerObjects(info, Loc.Ptr);
+	if (!loc.Valid || loc.Unknown || loc.Objects.empty())
+		return AAResultBase::getModRefInfo(CS, Loc);
+	for (unsigned object : loc.Objects) {
+		if (info.Solver.isEscaped(object))
+			return AAResultBase::getModRefInfo(CS, Loc);
+	}
+	for (const Value * argument : CS.args()) {
+		const PointerObjects &objects = getPointerObjects(info, argument);
+		if (!objects.Valid)
+			return AAResultBase::getModRefInfo(CS, Loc);
+		for (unsigned object : objects.Objects) {
+			if (std::binary_search(loc.Objects.begin(), loc.Objects.end(), object))
+				return AAResultBase::getModRefInfo(CS, Loc);
+		}
+	}
+	return MRI_NoModRef;
+}
+
+bool DFAAAResult::invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &) {
+	auto PAC = PA.getChecker<DFAAA>();
+	return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>());
+}
+
+void DFAAAResult::DeletionHandle::deleted() {
+	Info->Deleted.insert(getValPtr());
+	Info->Pointers.erase(getValPtr());
+	setValPtr(nullptr);
+}
+
+DFAAAResult::FunctionInfo &DFAAAResult::getFunctionInfo(Function * F) {
+	std::unique_ptr<FunctionInfo> &info = Functions[F];
+	if (info)
+		return *info;
+	info.reset(new FunctionInfo());
+	info->Solver.analyze(F);
+	unsigned numInstructions = 0;
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+		++numInstructions;
+	// Reserved so the handles never move
+	info->Handles.reserve(numInstructions);
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+		info->Handles.emplace_back(&*I, info.get());
+	return *info;
+}
+
+const DFAAAResult::PointerObjects &DFAAAResult::getPointerObjects(FunctionInfo &info, const Value * V) {
+	auto it = info.Pointers.find(V);
+	if (it != info.Pointers.end())
+		return it->second;
+	PointerObjects &objects = info.Pointers[V];
+	objects.Valid = !info.Deleted.count(V) &&
+		info.Solver.getObjects(const_cast<Value *>(V), objects.Objects, objects.Unknown);
+	return objects;
+}
+
+Function * DFAAAResult::getParentFunction(const Value * V) {
+	if (const Instruction * I = dyn_cast<Instruction>(V))
+		return const_cast<Function *>(I->getFunction());
+	if (const Argument * A = dyn_cast<Argument>(V))
+		return const_cast<Function *>(A->getParent());
+	return nullptr;
+}
+
+AnalysisKey DFAAA::Key;
+
+DFAAAResult DFAAA::run(Function &F, FunctionAnalysisManager &FAM) {
+	return DFAAAResult();
+}
+
+/*
+ * AAResultsWrapperPass calls back every time it builds the results of F,
+ * which it does again after any pass that changed F. The solution of F may be
+ * out of date by then.
+ */
+DFAAAWrapperPass::DFAAAWrapperPass() : ExternalAAWrapperPass([this](Pass &, Function &F, AAResults &AAR) {
+	Result.evict(&F);
+	AAR.addAAResult(Result);
+}) {}
+
+char DFAAAWrapperPass::ID = 0;
+static RegisterPass<DFAAAWrapperPass> X("cse231-aa", "alias analysis from the may-point-to sets",
+                             false /* Only looks at CFG */,
+                             true /* Analysis Pass */);
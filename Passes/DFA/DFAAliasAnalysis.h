@@ -0,0 +1,335 @@
+//===- DFAAliasAnalysis.h - Alias analysis on the CSE 231 DFA points-to sets -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides an alias analysis that answers the queries of the LLVM
+// optimizers from may-point-to sets, so GVN, LICM, DSE or MemCpyOpt can tell
+// apart pointers into different allocas where BasicAA cannot.
+//
+// The queries have no program point, so the sets are the flow-insensitive ones
+// of Andersen's solver, extended to every instruction of the function: memory
+// the function cannot see (arguments, globals, what calls return, ...) is one
+// object, Unknown, and the allocas whose address may reach it are escaped.
+// Two pointers do not alias if they point to disjoint allocas, or if one of
+// them may point to Unknown and the other only to allocas that do not escape.
+//
+// The solution of each function is computed on the first query and kept, with
+// the objects of every pointer queried, until the function changes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_DFAALIASANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_DFAALIASANALYSIS_H
+
+#include "FlowInsensitivePointsTo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Pass.h"
+#include <memory>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Andersen's solver over every instruction, so that the set of a value holds
+ * everything it may point to. Every value of the function can carry a pointer,
+ * integers included: the other instructions copy the sets of their operands,
+ * and calls, returns and memory intrinsics have their own constraints.
+ *
+ * Unknown stands for all the memory the function does not allocate and for
+ * every escaped alloca. Its memory points to Unknown, and whatever is stored in
+ * escaped memory escapes too.
+ */
+class EscapePointsTo : public AndersenPointsTo {
+  public:
+    EscapePointsTo() : Unknown(NoNode), UnknownNode(NoNode) {}
+
+    void analyze(Function * F) {
+    	Unknown = UnknownNode = NoNode;
+    	runWorklistAlgorithm(F);
+    }
+
+    /*
+     * The allocas V may point to, in increasing index order, and in unknown
+     * whether it may point to Unknown. Returns false if V is an instruction
+     * the solver has not seen.
+     */
+    bool getObjects(Value * V, SmallVectorImpl<unsigned> &objects, bool &unknown) {
+    	objects.clear();
+    	unknown = false;
+    	if (Instruction * I = dyn_cast<Instruction>(V)) {
+    		unsigned idx = getIndexOf(I);
+    		if (idx == 0)
+    			return false;
+    		getPointees(registerNode(idx), objects);
+    		if (Unknown != NoNode && !objects.empty() && objects.back() == Unknown) {
+    			objects.pop_back();
+    			unknown = true;
+    		}
+    		return true;
+    	}
+    	unknown = !isa<ConstantData>(V);
+    	return true;
+    }
+
+    bool isEscaped(unsigned object) {
+    	return Escaped.test(object);
+    }
+
+  protected:
+    unsigned getValueNode(Value * V) override {
+    	if (isa<Instruction>(V))
+    		return AndersenPointsTo::getValueNode(V);
+    	if (isa<ConstantData>(V))
+    		return NoNode;
+    	return getUnknownNode();
+    }
+
+    void collectOtherConstraints(Instruction * I, unsigned idx) override {
+    	switch (I->getOpcode()) {
+    	case Instruction::Call:
+    		addCallConstraints(cast<CallInst>(I), idx);
+    		break;
+    	case Instruction::Invoke:
+    		addCallConstraints(cast<InvokeInst>(I), idx);
+    		break;
+    	case Instruction::ICmp:
+    	case Instruction::FCmp:
+    		break;
+    	case Instruction::Ret:
+    	case Instruction::Resume:
+    		for (Value * operand : I->operands())
+    			escape(operand);
+    		break;
+    	case Instruction::AtomicCmpXchg:
+    		addMemoryConstraints(idx, cast<AtomicCmpXchgInst>(I)->getPointerOperand(),
+    		                     cast<AtomicCmpXchgInst>(I)->getNewValOperand());
+    		break;
+    	case Instruction::AtomicRMW:
+    		addMemoryConstraints(idx, cast<AtomicRMWInst>(I)->getPointerOperand(),
+    		                     cast<AtomicRMWInst>(I)->getValOperand());
+    		break;
+    	case Instruction::VAArg:
+    	case Instruction::LandingPad:
+    		addConstraint(PointsToConstraint::Copy, registerNode(idx), getUnknownNode());
+    		break;
+    	case Instruction::IntToPtr:
+    		addConstraint(PointsToConstraint::Copy, registerNode(idx), getUnknownNode());
+    		addCopies(I, idx);
+    		break;
+    	default:
+    		addCopies(I, idx);
+    		break;
+    	}
+    }
+
+    void solve() override {
+    	AndersenPointsTo::solve();
+    	Escaped.clear();
+    	if (Unknown == NoNode)
+    		return;
+    	SmallVector<unsigned, 16> escaped;
+    	getPointees(memoryNode(Unknown), escaped);
+    	for (unsigned object : escaped)
+    		Escaped.set(object);
+    }
+
+  private:
+    unsigned getUnknownNode() {
+    	if (UnknownNode != NoNode)
+    		return UnknownNode;
+    	Unknown = newObject();
+    	UnknownNode = registerNode(newId());
+    	addConstraint(PointsToConstraint::AddressOf, UnknownNode, Unknown);
+    	addConstraint(PointsToConstraint::AddressOf, memoryNode(Unknown), Unknown);
+    	// Code outside the function may load any escaped pointer and store it in
+    	// any escaped memory.
+    	addConstraint(PointsToConstraint::Load, memoryNode(Unknown), memoryNode(Unknown));
+    	addConstraint(PointsToConstraint::Store, memoryNode(Unknown), memoryNode(Unknown));
+    	return UnknownNode;
+    }
+
+    void escape(Value * V) {
+    	unsigned node = getValueNode(V);
+    	if (node != NoNode)
+    		addConstraint(PointsToConstraint::Store, getUnknownNode(), node);
+    }
+
+    void addCopies(Instruction * I, unsigned idx) {
+    	if (I->getType()->isVoidTy())
+    		return;
+    	for (Value * operand : I->operands()) {
+    		unsigned node = getValueNode(operand);
+    		if (node != NoNode)
+    			addConstraint(PointsToConstraint::Copy, registerNode(idx), node);
+    	}
+    }
+
+    /*
+     * An atomic instruction storing value through pointer and returning the old
+     * content of the memory.
+     */
+    void addMemoryConstraints(unsigned idx, Value * pointer, Value * value) {
+    	unsigned pointerNode = getValueNode(pointer);
+    	unsigned valueNode = getValueNode(value);
+    	if (pointerNode == NoNode)
+    		return;
+    	addConstraint(PointsToConstraint::Load, registerNode(idx), pointerNode);
+    	if (valueNode != NoNode)
+    		addConstraint(PointsToConstraint::Store, pointerNode, valueNode);
+    }
+
+    /*
+     * The arguments of a call escape and its result may point anywhere, except
+     * for the intrinsics that only touch the memory of their arguments.
+     */
+    template <class CallT>
+    void addCallConstraints(CallT * call, unsigned idx) {
+    	if (IntrinsicInst * intrinsic = dyn_cast<IntrinsicInst>(call)) {
+    		switch (intrinsic->getIntrinsicID()) {
+    		case Intrinsic::lifetime_start:
+    		case Intrinsic::lifetime_end:
+    		case Intrinsic::dbg_declare:
+    		case Intrinsic::dbg_value:
+    		case Intrinsic::memset:
+    			return;
+    		case Intrinsic::memcpy:
+    		case Intrinsic::memmove: {
+    			MemTransferInst * transfer = cast<MemTransferInst>(intrinsic);
+    			unsigned dst = getValueNode(transfer->getRawDest());
+    			unsigned src = getValueNode(transfer->getRawSource());
+    			if (dst == NoNode || src == NoNode)
+    				return;
+    			unsigned copied = registerNode(newId());
+    			addConstraint(PointsToConstraint::Load, copied, src);
+    			addConstraint(PointsToConstraint::Store, dst, copied);
+    			return;
+    		}
+    		default:
+    			break;
+    		}
+    	}
+    	for (Value * argument : call->arg_operands())
+    		escape(argument);
+    	if (!call->getType()->isVoidTy())
+    		addConstraint(PointsToConstraint::Copy, registerNode(idx), getUnknownNode());
+    }
+
+    unsigned Unknown;
+    unsigned UnknownNode;
+    SparseBitVector<> Escaped;
+};
+
+/*
+ * Alias analysis result over the functions of a module. The legacy wrapper
+ * keeps one for every function it is queried on; the new pass manager builds
+ * one per function.
+ */
+class DFAAAResult : public AAResultBase<DFAAAResult> {
+	friend AAResultBase<DFAAAResult>;
+
+public:
+	DFAAAResult();
+	DFAAAResult(DFAAAResult &&other);
+	~DFAAAResult();
+
+	AliasResult alias(const MemoryLocation &LocA, const MemoryLocation &LocB);
+
+	using AAResultBase::getModRefInfo;
+	ModRefInfo getModRefInfo(ImmutableCallSite CS, const MemoryLocation &Loc);
+
+	bool invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &);
+
+	/*
+	 * Drop the solution of F, recomputed on the next query.
+	 */
+	void evict(const Function * F) {
+		Functions.erase(F);
+	}
+
+private:
+	struct PointerObjects {
+		SmallVector<unsigned, 4> Objects;
+		bool Unknown;
+		// False for the values the solver has not seen
+		bool Valid;
+	};
+
+	struct FunctionInfo;
+
+	/*
+	 * Forgets a deleted instruction, so that a new one allocated at the same
+	 * address is not taken for it.
+	 */
+	class DeletionHandle final : public CallbackVH {
+	public:
+		DeletionHandle(Value * V, FunctionInfo * info) : CallbackVH(V), Info(info) {}
+
+		void deleted() override;
+
+	private:
+		FunctionInfo * Info;
+	};
+
+	struct FunctionInfo {
+		EscapePointsTo Solver;
+		// Objects of the values queried so far
+		DenseMap<const Value *, PointerObjects> Pointers;
+		DenseSet<const Value *> Deleted;
+		std::vector<DeletionHandle> Handles;
+	};
+
+	FunctionInfo &getFunctionInfo(Function * F);
+	const PointerObjects &getPointerObjects(FunctionInfo &info, const Value * V);
+	static Function * getParentFunction(const Value * V);
+
+	DenseMap<const Function *, std::unique_ptr<FunctionInfo>> Functions;
+};
+
+/*
+ * The analysis for the new pass manager. Add it to the alias analyses of the
+ * pipeline with AAManager::registerFunctionAnalysis<DFAAA>().
+ */
+class DFAAA : public AnalysisInfoMixin<DFAAA> {
+	friend AnalysisInfoMixin<DFAAA>;
+	static AnalysisKey Key;
+
+public:
+	typedef DFAAAResult Result;
+
+	Result run(Function &F, FunctionAnalysisManager &FAM);
+};
+
+/*
+ * The analysis for the legacy pass manager, -cse231-aa. As an
+ * ExternalAAWrapperPass, it adds itself to the AAResults of every function
+ * the passes after it query.
+ */
+class DFAAAWrapperPass : public ExternalAAWrapperPass {
+public:
+	static char ID;
+
+	DFAAAWrapperPass();
+
+	DFAAAResult &getResult() {
+		return Result;
+	}
+
+private:
+	DFAAAResult Result;
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_DFAALIASANALYSIS_H
@@ -0,0 +1,74 @@
+//===- DFAAnalyses.cpp - New pass manager analyses of CSE 231 DFA --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the analyses declared in DFAAnalyses.h.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DFAAnalyses.h"
+#include "DFAAliasAnalysis.h"
+#include <set>
+
+using namespace llvm;
+
+AnalysisKey ReachingDFAAnalysis::Key;
+AnalysisKey LivenessDFAAnalysis::Key;
+AnalysisKey MayPointToDFAAnalysis::Key;
+
+ReachingDFAResult ReachingDFAAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+	ReachingInfo bottom;
+	std::unique_ptr<ReachingDFA> analysis(new ReachingDFA(bottom, bottom));
+	analysis->runWorklistAlgorithm(&F);
+	return ReachingDFAResult(std::move(analysis));
+}
+
+LivenessDFAResult LivenessDFAAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+	LivenessInfo bottom;
+	std::unique_ptr<LivenessDFA> analysis(new LivenessDFA(bottom, bottom));
+	analysis->runWorklistAlgorithm(&F);
+	return LivenessDFAResult(std::move(analysis));
+}
+
+MayPointToDFAResult MayPointToDFAAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+	MayPointToInfo bottom;
+	std::unique_ptr<MayPointToDFA> analysis(new MayPointToDFA(bottom, bottom));
+	analysis->runWorklistAlgorithm(&F);
+	return MayPointToDFAResult(std::move(analysis));
+}
+
+void ReachingDFAResult::getReachingDefinitions(Instruction * I, SmallVectorImpl<Instruction *> &defs) const {
+	DenseIndexSet reaching;
+	Analysis->anyIncomingInfo(I, [&](const ReachingInfo &info) {
+		reaching.unionWith(info.getInfo());
+		return false;
+	});
+	reaching.forEach([&](unsigned idx) { defs.push_back(Analysis->getInstrOf(idx)); });
+}
+
+void MayPointToDFAResult::getPointees(Value * P, Instruction * I, SmallVectorImpl<Instruction *> &allocas) const {
+	Instruction * pointer = dyn_cast<Instruction>(P);
+	unsigned pointerIndex = pointer ? Analysis->getIndexOf(pointer) : 0;
+	if (pointerIndex == 0)
+		return;
+	std::set<unsigned> pointees;
+	Analysis->anyIncomingInfo(I, [&](const MayPointToInfo &info) {
+		if (const PointsToSet * set = info.getPointees(pointerIndex))
+			pointees.insert(set->elements().begin(), set->elements().end());
+		return false;
+	});
+	for (unsigned idx : pointees)
+		allocas.push_back(Analysis->getInstrOf(idx));
+}
+
+void llvm::registerDFAAnalyses(FunctionAnalysisManager &FAM) {
+	FAM.registerPass([] { return ReachingDFAAnalysis(); });
+	FAM.registerPass([] { return LivenessDFAAnalysis(); });
+	FAM.registerPass([] { return MayPointToDFAAnalysis(); });
+	FAM.registerPass([] { return DFAAA(); });
+}
@@ -0,0 +1,197 @@
+//===- DFAAnalyses.h - New pass manager analyses of CSE 231 DFA ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file exposes the reaching definition, liveness and may-point-to analyses
+// to the new pass manager. Their results are cached by the
+// FunctionAnalysisManager, so every pass asking for them on the same function
+// shares one computation until a pass invalidates it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_DFAANALYSES_H
+#define LLVM_TRANSFORMS_231DFA_DFAANALYSES_H
+
+#include "231DFA.h"
+#include "ReachingDefinitionAnalysis.h"
+#include "LivenessAnalysis.h"
+#include "MayPointToAnalysis.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/PassManager.h"
+#include <memory>
+
+namespace llvm {
+
+typedef ReachingDefinitionAnalysis<ReachingInfo, true> ReachingDFA;
+typedef LivenessAnalysis<LivenessInfo, false> LivenessDFA;
+typedef MayPointToAnalysis<MayPointToInfo, true> MayPointToDFA;
+
+/*
+ * Common part of the cached results: ownership of the solved analysis and
+ * invalidation. The information of an edge refers to instructions by index,
+ * so any change to the function, not only to its CFG, invalidates the result
+ * unless the pass preserved the analysis explicitly.
+ */
+template <class AnalysisT, class AnalysisPassT>
+class CachedDFAResult {
+  public:
+    explicit CachedDFAResult(std::unique_ptr<AnalysisT> analysis) : Analysis(std::move(analysis)) {}
+
+    AnalysisT &getAnalysis() {
+    	return *Analysis;
+    }
+
+    const AnalysisT &getAnalysis() const {
+    	return *Analysis;
+    }
+
+    bool invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &) {
+    	auto PAC = PA.getChecker<AnalysisPassT>();
+    	return !(PAC.preserved() || PAC.template preservedSet<AllAnalysesOn<Function>>());
+    }
+
+  protected:
+    std::unique_ptr<AnalysisT> Analysis;
+};
+
+class ReachingDFAAnalysis;
+class LivenessDFAAnalysis;
+class MayPointToDFAAnalysis;
+
+class ReachingDFAResult : public CachedDFAResult<ReachingDFA, ReachingDFAAnalysis> {
+  public:
+    explicit ReachingDFAResult(std::unique_ptr<ReachingDFA> analysis) :
+    	CachedDFAResult<ReachingDFA, ReachingDFAAnalysis>(std::move(analysis)) {}
+
+    /*
+     * Whether the definition def may reach the point right before I.
+     */
+    bool reaches(Instruction * def, Instruction * I) const {
+    	unsigned defIndex = Analysis->getIndexOf(def);
+    	return defIndex != 0 && Analysis->anyIncomingInfo(I, [&](const ReachingInfo &info) {
+    		return info.getInfo().contains(defIndex);
+    	});
+    }
+
+    /*
+     * The definitions that may reach the point right before I, in index order.
+     */
+    void getReachingDefinitions(Instruction * I, SmallVectorImpl<Instruction *> &defs) const;
+};
+
+class LivenessDFAResult : public CachedDFAResult<LivenessDFA, LivenessDFAAnalysis> {
+  public:
+    explicit LivenessDFAResult(std::unique_ptr<LivenessDFA> analysis) :
+    	CachedDFAResult<LivenessDFA, LivenessDFAAnalysis>(std::move(analysis)) {}
+
+    /*
+     * Whether V may be used after I executes, on some path leaving I. Only the
+     * values of the instructions tracked by the analysis are ever live.
+     */
+    bool isLiveAfter(Value * V, Instruction * I) const {
+    	unsigned index = getValueIndex(V);
+    	return index != 0 && Analysis->anyIncomingInfo(I, [&](const LivenessInfo &info) {
+    		return info.getInfo().contains(index);
+    	});
+    }
+
+    /*
+     * Whether V may be used by I or after it, on some path entering I.
+     */
+    bool isLiveBefore(Value * V, Instruction * I) const {
+    	unsigned index = getValueIndex(V);
+    	return index != 0 && Analysis->anyOutgoingInfo(I, [&](const LivenessInfo &info) {
+    		return info.getInfo().contains(index);
+    	});
+    }
+
+  private:
+    unsigned getValueIndex(Value * V) const {
+    	Instruction * I = dyn_cast<Instruction>(V);
+    	return I ? Analysis->getIndexOf(I) : 0;
+    }
+};
+
+class MayPointToDFAResult : public CachedDFAResult<MayPointToDFA, MayPointToDFAAnalysis> {
+  public:
+    explicit MayPointToDFAResult(std::unique_ptr<MayPointToDFA> analysis) :
+    	CachedDFAResult<MayPointToDFA, MayPointToDFAAnalysis>(std::move(analysis)) {}
+
+    /*
+     * Whether the pointer P may point to the memory allocated by alloca right
+     * before I. Only pointers defined by instructions are tracked.
+     */
+    bool mayPointTo(Value * P, Instruction * alloca, Instruction * I) const {
+    	Instruction * pointer = dyn_cast<Instruction>(P);
+    	unsigned pointerIndex = pointer ? Analysis->getIndexOf(pointer) : 0;
+    	unsigned allocaIndex = Analysis->getIndexOf(alloca);
+    	if (pointerIndex == 0 || allocaIndex == 0)
+    		return false;
+    	return Analysis->anyIncomingInfo(I, [&](const MayPointToInfo &info) {
+    		const PointsToSet * pointees = info.getPointees(pointerIndex);
+    		return pointees && pointees->contains(allocaIndex);
+    	});
+    }
+
+    /*
+     * The allocas P may point to right before I, in index order.
+     */
+    void getPointees(Value * P, Instruction * I, SmallVectorImpl<Instruction *> &allocas) const;
+};
+
+class ReachingDFAAnalysis : public AnalysisInfoMixin<ReachingDFAAnalysis> {
+	friend AnalysisInfoMixin<ReachingDFAAnalysis>;
+	static AnalysisKey Key;
+
+public:
+	typedef ReachingDFAResult Result;
+
+	Result run(Function &F, FunctionAnalysisManager &FAM);
+};
+
+class LivenessDFAAnalysis : public AnalysisInfoMixin<LivenessDFAAnalysis> {
+	friend AnalysisInfoMixin<LivenessDFAAnalysis>;
+	static AnalysisKey Key;
+
+public:
+	typedef LivenessDFAResult Result;
+
+	Result run(Function &F, FunctionAnalysisManager &FAM);
+};
+
+class MayPointToDFAAnalysis : public AnalysisInfoMixin<MayPointToDFAAnalysis> {
+	friend AnalysisInfoMixin<MayPointToDFAAnalysis>;
+	static AnalysisKey Key;
+
+public:
+	typedef MayPointToDFAResult Result;
+
+	Result run(Function &F, FunctionAnalysisManager &FAM);
+};
+
+/*
+ * Print the cached result of AnalysisT in the format of the legacy passes.
+ */
+template <class AnalysisT>
+class DFAPrinterPass : public PassInfoMixin<DFAPrinterPass<AnalysisT>> {
+public:
+	PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM) {
+		FAM.getResult<AnalysisT>(F).getAnalysis().print();
+		return PreservedAnalyses::all();
+	}
+};
+
+/*
+ * Register the three analyses and the alias analysis DFAAA with FAM. Tools
+ * building their own pipeline call this once before running passes that ask
+ * for the results.
+ */
+void registerDFAAnalyses(FunctionAnalysisManager &FAM);
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_DFAANALYSES_H
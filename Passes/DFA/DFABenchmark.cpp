@@ -0,0 +1,492 @@
+//===- DFABenchmark.cpp - Benchmark of the CSE 231 dataflow analyses ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements -cse231-dfa-bench, which runs every analysis built on
+// 231DFA.h on each function of a module and reports how long it took and how
+// much work it did. It can also generate synthetic functions of a given shape
+// and size, so the framework can be measured on CFGs much larger than the
+// test programs, and time the incremental update after a small edit.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include "231DFA.h"
+#include "ReachingDefinitionAnalysis.h"
+#include "LivenessAnalysis.h"
+#include "MayPointToAnalysis.h"
+#include "FlowInsensitivePointsTo.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+enum class BenchShape { LoopNest, Switch, StraightLine, Phi, Memory };
+
+static cl::list<BenchShape> BenchGenerate(
+	"cse231-bench-generate", cl::CommaSeparated,
+	cl::desc("Synthetic functions to add to the module before benchmarking"),
+	cl::values(clEnumValN(BenchShape::LoopNest, "loopnest", "loops nested size deep"),
+	           clEnumValN(BenchShape::Switch, "switch", "a switch with size cases"),
+	           clEnumValN(BenchShape::StraightLine, "straightline", "one block of size instructions"),
+	           clEnumValN(BenchShape::Phi, "phi", "size diamonds, each merged by phi nodes"),
+	           clEnumValN(BenchShape::Memory, "memory", "a loop over size allocas, stores and loads")));
+
+static cl::opt<unsigned> BenchSize("cse231-bench-size", cl::init(64),
+                                   cl::desc("Size of the generated functions"));
+
+static cl::opt<unsigned> BenchRepetitions("cse231-bench-reps", cl::init(3),
+                                          cl::desc("Runs of each analysis per function; the fastest is reported"));
+
+static cl::opt<bool> BenchIncremental("cse231-bench-incremental", cl::init(false),
+                                      cl::desc("Also time updateWorklistAlgorithm after a one-instruction edit"));
+
+/*
+ * Builders of the synthetic functions. Each one adds a function named
+ * bench_<shape>_<size> to M, taking two i32 arguments and returning i32.
+ */
+namespace {
+class BenchGenerator {
+public:
+	BenchGenerator(Module &M) : M(M), Ctx(M.getContext()), Builder(M.getContext()) {}
+
+	/*
+	 * Every shape needs at least one loop, case, diamond or alloca, so a size of
+	 * 0 builds the function of size 1.
+	 */
+	void generate(BenchShape shape, unsigned size) {
+		size = std::max(1u, size);
+		switch(shape){
+		case BenchShape::LoopNest:
+			generateLoopNest(size);
+			break;
+		case BenchShape::Switch:
+			generateSwitch(size);
+			break;
+		case BenchShape::StraightLine:
+			generateStraightLine(size);
+			break;
+		case BenchShape::Phi:
+			generatePhi(size);
+			break;
+		case BenchShape::Memory:
+			generateMemory(size);
+			break;
+		}
+	}
+
+private:
+	Module &M;
+	LLVMContext &Ctx;
+	IRBuilder<> Builder;
+
+	Function * createFunction(const std::string &shape, unsigned size) {
+		Type * i32 = Builder.getInt32Ty();
+		FunctionType * type = FunctionType::get(i32, {i32, i32}, false);
+		std::string name = "bench_" + shape + "_" + std::to_string(size);
+		return Function::Create(type, GlobalValue::ExternalLinkage, name, &M);
+	}
+
+	BasicBlock * createBlock(Function * F, const Twine &name) {
+		return BasicBlock::Create(Ctx, name, F);
+	}
+
+	/*
+	 * size loops nested in each other, counting up to the first argument.
+	 * The innermost body accumulates all induction variables into a stack slot.
+	 */
+	void generateLoopNest(unsigned size) {
+		Function * F = createFunction("loopnest", size);
+		Value * bound = &*F->arg_begin();
+		Type * i32 = Builder.getInt32Ty();
+
+		BasicBlock * entry = createBlock(F, "entry");
+		std::vector<BasicBlock *> headers, latches, exits;
+		for(unsigned k = 0; k < size; ++k){
+			headers.push_back(createBlock(F, "header" + Twine(k)));
+			latches.push_back(createBlock(F, "latch" + Twine(k)));
+			exits.push_back(createBlock(F, "exit" + Twine(k)));
+		}
+		BasicBlock * body = createBlock(F, "body");
+
+		Builder.SetInsertPoint(entry);
+		Value * acc = Builder.CreateAlloca(i32, nullptr, "acc");
+		Builder.CreateStore(Builder.getInt32(0), acc);
+		Builder.CreateBr(headers[0]);
+
+		std::vector<PHINode *> ivs;
+		for(unsigned k = 0; k < size; ++k){
+			Builder.SetInsertPoint(headers[k]);
+			PHINode * iv = Builder.CreatePHI(i32, 2, "i" + Twine(k));
+			iv->addIncoming(Builder.getInt32(0), k == 0 ? entry : headers[k - 1]);
+			ivs.push_back(iv);
+			Value * cond = Builder.CreateICmpSLT(iv, bound);
+			Builder.CreateCondBr(cond, k + 1 < size ? headers[k + 1] : body, exits[k]);
+
+			Builder.SetInsertPoint(latches[k]);
+			Value * next = Builder.CreateAdd(iv, Builder.getInt32(1));
+			iv->addIncoming(next, latches[k]);
+			Builder.CreateBr(headers[k]);
+		}
+
+		Builder.SetInsertPoint(body);
+		Value * sum = Builder.CreateLoad(i32, acc);
+		for(PHINode * iv : ivs)
+			sum = Builder.CreateXor(sum, iv);
+		Builder.CreateStore(sum, acc);
+		Builder.CreateBr(latches[size - 1]);
+
+		for(unsigned k = 0; k < size; ++k){
+			Builder.SetInsertPoint(exits[k]);
+			if(k == 0)
+				Builder.CreateRet(Builder.CreateLoad(i32, acc));
+			else
+				Builder.CreateBr(latches[k - 1]);
+		}
+	}
+
+	/*
+	 * A switch on the first argument with size cases that all meet in one phi node.
+	 */
+	void generateSwitch(unsigned size) {
+		Function * F = createFunction("switch", size);
+		Value * x = &*F->arg_begin();
+		Value * y = &*std::next(F->arg_begin());
+		Type * i32 = Builder.getInt32Ty();
+
+		BasicBlock * entry = createBlock(F, "entry");
+		BasicBlock * merge = createBlock(F, "merge");
+		Builder.SetInsertPoint(entry);
+		Value * base = Builder.CreateMul(x, y);
+		SwitchInst * sw = Builder.CreateSwitch(x, merge, size);
+
+		Builder.SetInsertPoint(merge);
+		PHINode * result = Builder.CreatePHI(i32, size + 1, "result");
+		result->addIncoming(base, entry);
+
+		for(unsigned k = 0; k < size; ++k){
+			BasicBlock * block = createBlock(F, "case" + Twine(k));
+			sw->addCase(Builder.getInt32(k), block);
+			Builder.SetInsertPoint(block);
+			Value * v = Builder.CreateAdd(base, Builder.getInt32(k));
+			v = Builder.CreateShl(v, Builder.getInt32(k % 31));
+			v = Builder.CreateSub(v, y);
+			Builder.CreateBr(merge);
+			result->addIncoming(v, block);
+		}
+
+		Builder.SetInsertPoint(merge);
+		Builder.CreateRet(result);
+	}
+
+	/*
+	 * One block of size arithmetic instructions, each using the two before it.
+	 */
+	void generateStraightLine(unsigned size) {
+		Function * F = createFunction("straightline", size);
+		Value * a = &*F->arg_begin();
+		Value * b = &*std::next(F->arg_begin());
+
+		BasicBlock * entry = createBlock(F, "entry");
+		Builder.SetInsertPoint(entry);
+		for(unsigned k = 0; k < size; ++k){
+			Value * v;
+			switch(k % 4){
+			case 0: v = Builder.CreateAdd(a, b); break;
+			case 1: v = Builder.CreateMul(a, b); break;
+			case 2: v = Builder.CreateXor(a, b); break;
+			default: v = Builder.CreateSub(a, b); break;
+			}
+			a = b;
+			b = v;
+		}
+		Builder.CreateRet(b);
+	}
+
+	/*
+	 * size diamonds in a row. Each join block merges four values with phi nodes.
+	 */
+	void generatePhi(unsigned size) {
+		Function * F = createFunction("phi", size);
+		Value * x = &*F->arg_begin();
+		Value * y = &*std::next(F->arg_begin());
+		Type * i32 = Builder.getInt32Ty();
+		const unsigned numPhis = 4;
+
+		BasicBlock * entry = createBlock(F, "entry");
+		Builder.SetInsertPoint(entry);
+		std::vector<Value *> values;
+		for(unsigned p = 0; p < numPhis; ++p)
+			values.push_back(Builder.CreateAdd(x, Builder.getInt32(p)));
+
+		BasicBlock * current = entry;
+		for(unsigned k = 0; k < size; ++k){
+			BasicBlock * left = createBlock(F, "left" + Twine(k));
+			BasicBlock * right = createBlock(F, "right" + Twine(k));
+			BasicBlock * join = createBlock(F, "join" + Twine(k));
+
+			Builder.SetInsertPoint(current);
+			Value * cond = Builder.CreateICmpSLT(values[k % numPhis], y);
+			Builder.CreateCondBr(cond, left, right);
+
+			std::vector<Value *> leftValues, rightValues;
+			Builder.SetInsertPoint(left);
+			for(unsigned p = 0; p < numPhis; ++p)
+				leftValues.push_back(Builder.CreateAdd(values[p], values[(p + 1) % numPhis]));
+			Builder.CreateBr(join);
+			Builder.SetInsertPoint(right);
+			for(unsigned p = 0; p < numPhis; ++p)
+				rightValues.push_back(Builder.CreateSub(values[p], y));
+			Builder.CreateBr(join);
+
+			Builder.SetInsertPoint(join);
+			for(unsigned p = 0; p < numPhis; ++p){
+				PHINode * phi = Builder.CreatePHI(i32, 2);
+				phi->addIncoming(leftValues[p], left);
+				phi->addIncoming(rightValues[p], right);
+				values[p] = phi;
+			}
+			current = join;
+		}
+
+		Builder.SetInsertPoint(current);
+		Value * sum = values[0];
+		for(unsigned p = 1; p < numPhis; ++p)
+			sum = Builder.CreateAdd(sum, values[p]);
+		Builder.CreateRet(sum);
+	}
+
+	/*
+	 * size integer slots and size pointer slots. A loop stores the address of
+	 * each integer slot into a pointer slot, then loads the pointers back and
+	 * mixes them with getelementptr, bitcast and select.
+	 */
+	void generateMemory(unsigned size) {
+		Function * F = createFunction("memory", size);
+		Value * x = &*F->arg_begin();
+		Value * y = &*std::next(F->arg_begin());
+		Type * i32 = Builder.getInt32Ty();
+		Type * i8Ptr = Builder.getInt8PtrTy();
+
+		BasicBlock * entry = createBlock(F, "entry");
+		BasicBlock * loop = createBlock(F, "loop");
+		BasicBlock * exit = createBlock(F, "exit");
+
+		Builder.SetInsertPoint(entry);
+		std::vector<Value *> ints, ptrs;
+		for(unsigned k = 0; k < size; ++k){
+			ints.push_back(Builder.CreateAlloca(i32, nullptr, "int" + Twine(k)));
+			ptrs.push_back(Builder.CreateAlloca(i8Ptr, nullptr, "ptr" + Twine(k)));
+		}
+		Builder.CreateBr(loop);
+
+		Builder.SetInsertPoint(loop);
+		PHINode * iv = Builder.CreatePHI(i32, 2, "iv");
+		iv->addIncoming(Builder.getInt32(0), entry);
+		Value * cond = Builder.CreateICmpSLT(iv, y);
+		for(unsigned k = 0; k < size; ++k){
+			Builder.CreateStore(Builder.CreateAdd(iv, x), ints[k]);
+			Value * address = Builder.CreateBitCast(ints[(k + 1) % size], i8Ptr);
+			Builder.CreateStore(address, ptrs[k]);
+		}
+		Value * last = nullptr;
+		for(unsigned k = 0; k < size; ++k){
+			Value * loaded = Builder.CreateLoad(i8Ptr, ptrs[k]);
+			Value * offset = Builder.CreateGEP(Builder.getInt8Ty(), loaded, Builder.getInt32(0));
+			last = last ? Builder.CreateSelect(cond, last, offset) : offset;
+		}
+		Builder.CreateStore(last, ptrs[0]);
+		Value * next = Builder.CreateAdd(iv, Builder.getInt32(1));
+		iv->addIncoming(next, loop);
+		Builder.CreateCondBr(cond, loop, exit);
+
+		Builder.SetInsertPoint(exit);
+		Builder.CreateRet(Builder.CreateLoad(i32, ints[0]));
+	}
+};
+
+struct BenchmarkResult {
+	double Milliseconds = 0;
+	WorklistStatistics Stats;
+	unsigned PeakInfos = 0;
+	size_t ArenaBytes = 0;
+	size_t HeapBytes = 0;
+};
+
+/*
+ * Run AnalysisT on F BenchRepetitions times and keep the fastest run.
+ * The work counters are the same on every run. HeapBytes is the growth of the
+ * malloc heap while the solved analysis is still alive, i.e. what it retains.
+ */
+template <class AnalysisT, class InfoT>
+BenchmarkResult benchmarkAnalysis(Function &F) {
+	BenchmarkResult result;
+	for(unsigned rep = 0; rep < std::max(1u, (unsigned)BenchRepetitions); ++rep){
+		InfoT bottom;
+		size_t heapBefore = sys::Process::GetMallocUsage();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		AnalysisT analysis(bottom, bottom);
+		analysis.runWorklistAlgorithm(&F);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		size_t heapAfter = sys::Process::GetMallocUsage();
+
+		if(rep == 0 || elapsed.count() < result.Milliseconds)
+			result.Milliseconds = elapsed.count();
+		result.Stats = analysis.getStatistics();
+		result.PeakInfos = analysis.getPool().getPeakLive();
+		result.ArenaBytes = analysis.getPool().getArenaBytes();
+		result.HeapBytes = heapAfter > heapBefore ? heapAfter - heapBefore : 0;
+	}
+	return result;
+}
+
+/*
+ * benchmarkAnalysis for the flow-insensitive points-to solvers, which hold a
+ * single Info for the whole function and no pool.
+ */
+template <class SolverT>
+BenchmarkResult benchmarkSolver(Function &F) {
+	BenchmarkResult result;
+	for(unsigned rep = 0; rep < std::max(1u, (unsigned)BenchRepetitions); ++rep){
+		MayPointToInfo bottom;
+		size_t heapBefore = sys::Process::GetMallocUsage();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		SolverT solver(bottom, bottom);
+		solver.runWorklistAlgorithm(&F);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		size_t heapAfter = sys::Process::GetMallocUsage();
+
+		if(rep == 0 || elapsed.count() < result.Milliseconds)
+			result.Milliseconds = elapsed.count();
+		result.Stats = solver.getStatistics();
+		result.PeakInfos = 1;
+		result.HeapBytes = heapAfter > heapBefore ? heapAfter - heapBefore : 0;
+	}
+	return result;
+}
+
+/*
+ * Instruction the incremental benchmark copies: the first defining instruction
+ * from the middle block of F onwards, or nullptr.
+ */
+Instruction * findEditPoint(Function &F) {
+	std::vector<BasicBlock *> blocks;
+	for(BasicBlock &BB : F)
+		blocks.push_back(&BB);
+	for(unsigned i = blocks.size() / 2; i < blocks.size(); ++i){
+		for(Instruction &I : *blocks[i]){
+			if(isDefiningInstr(&I))
+				return &I;
+		}
+	}
+	return nullptr;
+}
+
+/*
+ * Solve AnalysisT on F, then BenchRepetitions times insert a copy of the
+ * instruction of findEditPoint right after it and time the update of the
+ * results, keeping the fastest. The copy is removed after each repetition.
+ */
+template <class AnalysisT, class InfoT>
+BenchmarkResult benchmarkIncremental(Function &F, Instruction * point) {
+	BenchmarkResult result;
+	InfoT bottom;
+	AnalysisT analysis(bottom, bottom);
+	analysis.runWorklistAlgorithm(&F);
+	for(unsigned rep = 0; rep < std::max(1u, (unsigned)BenchRepetitions); ++rep){
+		Instruction * copy = point->clone();
+		copy->insertAfter(point);
+		analysis.invalidateInstruction(copy);
+
+		size_t heapBefore = sys::Process::GetMallocUsage();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		analysis.updateWorklistAlgorithm(&F);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		size_t heapAfter = sys::Process::GetMallocUsage();
+
+		if(rep == 0 || elapsed.count() < result.Milliseconds)
+			result.Milliseconds = elapsed.count();
+		result.Stats = analysis.getStatistics();
+		result.PeakInfos = analysis.getPool().getPeakLive();
+		result.ArenaBytes = analysis.getPool().getArenaBytes();
+		result.HeapBytes = heapAfter > heapBefore ? heapAfter - heapBefore : 0;
+
+		analysis.invalidateInstruction(copy);
+		copy->eraseFromParent();
+		analysis.updateWorklistAlgorithm(&F);
+	}
+	return result;
+}
+
+void printResult(StringRef function, StringRef analysis, unsigned numInstrs, const BenchmarkResult &result) {
+	errs() << format("%-28s %-14s %8u %10.3f %10u %10u %10u %10u %12zu %12zu\n",
+	                 function.str().c_str(), analysis.str().c_str(), numInstrs, result.Milliseconds,
+	                 result.Stats.FlowFunctionCalls, result.Stats.Joins, result.Stats.WorklistPushes,
+	                 result.PeakInfos, result.ArenaBytes / 1024, result.HeapBytes / 1024);
+}
+
+struct DFABenchmarkPass : public ModulePass {
+ 	static char ID;
+  	DFABenchmarkPass() : ModulePass(ID) {}
+
+  	bool runOnModule(Module &M) override {
+  		BenchGenerator generator(M);
+  		for (BenchShape shape : BenchGenerate)
+  			generator.generate(shape, BenchSize);
+
+  		errs() << left_justify("function", 28) << " " << left_justify("analysis", 14)
+  		       << right_justify("instrs", 9) << right_justify("time(ms)", 11)
+  		       << right_justify("flowcalls", 11) << right_justify("joins", 11)
+  		       << right_justify("pushes", 11) << right_justify("peakinfos", 11)
+  		       << right_justify("arena(KB)", 13) << right_justify("heap(KB)", 13) << "\n";
+  		for (Function &F : M) {
+  			if (F.isDeclaration())
+  				continue;
+  			unsigned numInstrs = 0;
+  			for (BasicBlock &BB : F)
+  				numInstrs += BB.size();
+
+  			printResult(F.getName(), "reaching", numInstrs,
+  			            benchmarkAnalysis<ReachingDefinitionAnalysis<ReachingInfo, true>, ReachingInfo>(F));
+  			printResult(F.getName(), "liveness", numInstrs,
+  			            benchmarkAnalysis<LivenessAnalysis<LivenessInfo, false>, LivenessInfo>(F));
+  			printResult(F.getName(), "liveness-sp", numInstrs,
+  			            benchmarkAnalysis<SparseLivenessAnalysis, LivenessInfo>(F));
+  			printResult(F.getName(), "maypointto", numInstrs,
+  			            benchmarkAnalysis<MayPointToAnalysis<MayPointToInfo, true>, MayPointToInfo>(F));
+  			printResult(F.getName(), "andersen", numInstrs, benchmarkSolver<AndersenPointsTo>(F));
+  			printResult(F.getName(), "steensgaard", numInstrs, benchmarkSolver<SteensgaardPointsTo>(F));
+
+  			Instruction * point = BenchIncremental ? findEditPoint(F) : nullptr;
+  			if (!point)
+  				continue;
+  			printResult(F.getName(), "reaching-inc", numInstrs + 1,
+  			            benchmarkIncremental<ReachingDefinitionAnalysis<ReachingInfo, true>, ReachingInfo>(F, point));
+  			printResult(F.getName(), "liveness-inc", numInstrs + 1,
+  			            benchmarkIncremental<LivenessAnalysis<LivenessInfo, false>, LivenessInfo>(F, point));
+  			printResult(F.getName(), "maypointto-inc", numInstrs + 1,
+  			            benchmarkIncremental<MayPointToAnalysis<MayPointToInfo, true>, MayPointToInfo>(F, point));
+  		}
+
+  		return !BenchGenerate.empty();
+  	}
+}; // end of struct
+}  // end of anonymous namespace
+
+char DFABenchmarkPass::ID = 0;
+static RegisterPass<DFABenchmarkPass> X("cse231-dfa-bench", "benchmark of the dataflow analyses",
+                             false /* Only looks at CFG */,
+                             false /* Analysis Pass */);
@@ -0,0 +1,358 @@
+//===- DFAResult.h - Binary result files of the CSE 231 DFA --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a binary file holding the results of one analysis for all
+// the functions of a module, a writer filled from the analyses, and a reader
+// that works directly on the bytes of a memory-mapped file.
+//
+// Layout, all integers in the byte order of the writer:
+//
+//   DFAResultHeader
+//   DFAFunctionRecord[NumFunctions]     at FunctionsOffset
+//   DFAEdgeRecord[...]                  the edges of each function, sorted by (Src, Dst)
+//   uint32_t[...]                       at PayloadOffset: the encoded Info of the edges
+//   char[...]                           at StringsOffset: the function names
+//
+// The payload of an edge is what Info::encode appended for it. Edges with the
+// same information share one payload. The encodings are:
+//
+//   IndexSet: a bit vector of 32-bit words, index i being bit i % 32 of word
+//             i / 32, without trailing zero words.
+//   PointsTo: the register map then the memory map of MayPointToInfo, each as
+//             its number of entries followed by, for each entry, the pointer,
+//             the number of pointees and the pointees in increasing order.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_DFARESULT_H
+#define LLVM_TRANSFORMS_231DFA_DFARESULT_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+enum class DFAResultKind : uint32_t { IndexSet = 1, PointsTo = 2 };
+
+const char DFAResultMagic[8] = {'C', 'S', 'E', '2', '3', '1', 'D', 'F'};
+const uint32_t DFAResultVersion = 1;
+
+struct DFAResultHeader {
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Kind;
+	uint32_t NumFunctions;
+	uint32_t Reserved;
+	uint64_t FunctionsOffset;
+	uint64_t PayloadOffset;
+	uint64_t StringsOffset;
+};
+
+struct DFAFunctionRecord {
+	// Offset of the name from StringsOffset
+	uint64_t NameOffset;
+	uint32_t NameSize;
+	uint32_t NumEdges;
+	// Offset of the first DFAEdgeRecord from the start of the file
+	uint64_t EdgesOffset;
+};
+
+struct DFAEdgeRecord {
+	uint32_t Src;
+	uint32_t Dst;
+	// Offset of the payload from PayloadOffset, in 32-bit words
+	uint64_t PayloadOffset;
+	uint32_t PayloadSize;
+	uint32_t Reserved;
+};
+
+/*
+ * Collects the results of an analysis function by function, then writes them
+ * to a file in one go.
+ */
+class DFAResultWriter {
+  public:
+    DFAResultWriter() : Kind(DFAResultKind::IndexSet) {}
+
+    bool empty() const {
+    	return Functions.empty();
+    }
+
+    /*
+     * Add the edges of an analysis that has run on the function called name.
+     * AnalysisT::InfoType must provide encode() and ResultKind.
+     */
+    template <class AnalysisT>
+    void addFunction(StringRef name, AnalysisT &analysis) {
+    	typedef typename AnalysisT::InfoType InfoT;
+    	Kind = InfoT::ResultKind;
+    	Functions.push_back(FunctionData());
+    	FunctionData &function = Functions.back();
+    	function.Name = name.str();
+    	std::vector<uint32_t> words;
+    	analysis.forEachEdge([&](unsigned src, unsigned dst, InfoT * info) {
+    		words.clear();
+    		info->encode(words);
+    		DFAEdgeRecord edge;
+    		edge.Src = src;
+    		edge.Dst = dst;
+    		edge.PayloadOffset = intern(words);
+    		edge.PayloadSize = words.size();
+    		edge.Reserved = 0;
+    		function.Edges.push_back(edge);
+    	});
+    }
+
+    /*
+     * Write everything added so far to path. Reports the error and returns
+     * false if the file cannot be written.
+     */
+    bool write(StringRef path) const {
+    	DFAResultHeader header;
+    	memcpy(header.Magic, DFAResultMagic, sizeof(header.Magic));
+    	header.Version = DFAResultVersion;
+    	header.Kind = static_cast<uint32_t>(Kind);
+    	header.NumFunctions = Functions.size();
+    	header.Reserved = 0;
+    	header.FunctionsOffset = sizeof(DFAResultHeader);
+
+    	std::vector<DFAFunctionRecord> records;
+    	uint64_t edgesOffset = header.FunctionsOffset + Functions.size() * sizeof(DFAFunctionRecord);
+    	uint64_t nameOffset = 0;
+    	for (const FunctionData &function : Functions) {
+    		DFAFunctionRecord record;
+    		record.NameOffset = nameOffset;
+    		record.NameSize = function.Name.size();
+    		record.NumEdges = function.Edges.size();
+    		record.EdgesOffset = edgesOffset;
+    		records.push_back(record);
+    		nameOffset += function.Name.size();
+    		edgesOffset += function.Edges.size() * sizeof(DFAEdgeRecord);
+    	}
+    	header.PayloadOffset = edgesOffset;
+    	header.StringsOffset = header.PayloadOffset + Payload.size() * sizeof(uint32_t);
+
+    	std::ofstream out(path.str().c_str(), std::ios::binary | std::ios::trunc);
+    	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    	out.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(DFAFunctionRecord));
+    	for (const FunctionData &function : Functions)
+    		out.write(reinterpret_cast<const char *>(function.Edges.data()),
+    		          function.Edges.size() * sizeof(DFAEdgeRecord));
+    	out.write(reinterpret_cast<const char *>(Payload.data()), Payload.size() * sizeof(uint32_t));
+    	for (const FunctionData &function : Functions)
+    		out.write(function.Name.data(), function.Name.size());
+    	out.close();
+    	if (!out) {
+    		errs() << "error: cannot write the dataflow results to " << path << "\n";
+    		return false;
+    	}
+    	return true;
+    }
+
+  private:
+    struct FunctionData {
+    	std::string Name;
+    	std::vector<DFAEdgeRecord> Edges;
+    };
+
+    DFAResultKind Kind;
+    std::vector<FunctionData> Functions;
+    std::vector<uint32_t> Payload;
+    // Hash of a payload -> (offset, size) of the payloads in Payload with that hash
+    std::unordered_multimap<size_t, std::pair<uint64_t, uint32_t>> PayloadIndex;
+
+    /*
+     * Offset of words in Payload, appending them unless an equal payload is already there.
+     */
+    uint64_t intern(const std::vector<uint32_t> &words) {
+    	size_t hash = hash_combine_range(words.begin(), words.end());
+    	auto range = PayloadIndex.equal_range(hash);
+    	for (auto it = range.first; it != range.second; ++it) {
+    		if (it->second.second == words.size() &&
+    		    std::equal(words.begin(), words.end(), Payload.begin() + it->second.first))
+    			return it->second.first;
+    	}
+    	uint64_t offset = Payload.size();
+    	Payload.insert(Payload.end(), words.begin(), words.end());
+    	PayloadIndex.insert(std::make_pair(hash, std::make_pair(offset, (uint32_t)words.size())));
+    	return offset;
+    }
+};
+
+/*
+ * Read access to the bytes of a result file, without copying or parsing them.
+ * The buffer must outlive the reader and be 8-byte aligned, which a memory
+ * mapped file is.
+ */
+class DFAResultFile {
+  public:
+    DFAResultFile() : Data(nullptr), Size(0), Header(nullptr) {}
+
+    /*
+     * Check that data holds a well-formed result file. Nothing else may be
+     * called unless this returned true.
+     */
+    bool init(const char * data, size_t size) {
+    	Data = data;
+    	Size = size;
+    	if (size < sizeof(DFAResultHeader))
+    		return false;
+    	Header = reinterpret_cast<const DFAResultHeader *>(data);
+    	if (memcmp(Header->Magic, DFAResultMagic, sizeof(Header->Magic)) != 0 ||
+    	    Header->Version != DFAResultVersion ||
+    	    !isAligned(Header->FunctionsOffset, alignof(DFAFunctionRecord)) ||
+    	    !fits(Header->FunctionsOffset, uint64_t(Header->NumFunctions) * sizeof(DFAFunctionRecord)) ||
+    	    !isAligned(Header->PayloadOffset, alignof(uint32_t)) ||
+    	    Header->PayloadOffset > Header->StringsOffset || Header->StringsOffset > size ||
+    	    (Header->StringsOffset - Header->PayloadOffset) % sizeof(uint32_t) != 0)
+    		return false;
+
+    	// Written without additions, which a malformed offset could wrap around
+    	uint64_t numWords = (Header->StringsOffset - Header->PayloadOffset) / sizeof(uint32_t);
+    	for (unsigned f = 0; f < getNumFunctions(); ++f) {
+    		const DFAFunctionRecord &record = getFunction(f);
+    		if (!isAligned(record.EdgesOffset, alignof(DFAEdgeRecord)) ||
+    		    !fits(record.EdgesOffset, uint64_t(record.NumEdges) * sizeof(DFAEdgeRecord)) ||
+    		    !fits(Header->StringsOffset, record.NameOffset) ||
+    		    !fits(Header->StringsOffset + record.NameOffset, record.NameSize))
+    			return false;
+    		for (const DFAEdgeRecord &edge : getEdges(f))
+    			if (edge.PayloadOffset > numWords || edge.PayloadSize > numWords - edge.PayloadOffset)
+    				return false;
+    	}
+    	return true;
+    }
+
+    DFAResultKind getKind() const {
+    	return static_cast<DFAResultKind>(Header->Kind);
+    }
+
+    unsigned getNumFunctions() const {
+    	return Header->NumFunctions;
+    }
+
+    StringRef getFunctionName(unsigned f) const {
+    	const DFAFunctionRecord &record = getFunction(f);
+    	return StringRef(Data + Header->StringsOffset + record.NameOffset, record.NameSize);
+    }
+
+    /*
+     * Index of the function called name, or -1.
+     */
+    int findFunction(StringRef name) const {
+    	for (unsigned f = 0; f < getNumFunctions(); ++f)
+    		if (getFunctionName(f) == name)
+    			return f;
+    	return -1;
+    }
+
+    ArrayRef<DFAEdgeRecord> getEdges(unsigned f) const {
+    	const DFAFunctionRecord &record = getFunction(f);
+    	return ArrayRef<DFAEdgeRecord>(reinterpret_cast<const DFAEdgeRecord *>(Data + record.EdgesOffset),
+    	                               record.NumEdges);
+    }
+
+    /*
+     * The edge src -> dst of function f, or nullptr.
+     */
+    const DFAEdgeRecord * findEdge(unsigned f, unsigned src, unsigned dst) const {
+    	ArrayRef<DFAEdgeRecord> edges = getEdges(f);
+    	const DFAEdgeRecord * it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(src, dst),
+    		[](const DFAEdgeRecord &edge, const std::pair<unsigned, unsigned> &key) {
+    			return std::make_pair(edge.Src, edge.Dst) < key;
+    		});
+    	if (it == edges.end() || it->Src != src || it->Dst != dst)
+    		return nullptr;
+    	return it;
+    }
+
+    ArrayRef<uint32_t> getPayload(const DFAEdgeRecord &edge) const {
+    	const uint32_t * words = reinterpret_cast<const uint32_t *>(Data + Header->PayloadOffset);
+    	return ArrayRef<uint32_t>(words + edge.PayloadOffset, edge.PayloadSize);
+    }
+
+    /*
+     * For IndexSet results: whether the set of edge holds idx.
+     */
+    bool containsIndex(const DFAEdgeRecord &edge, unsigned idx) const {
+    	ArrayRef<uint32_t> words = getPayload(edge);
+    	return idx / 32 < words.size() && (words[idx / 32] >> (idx % 32)) & 1;
+    }
+
+    /*
+     * Print the edges of function f exactly as DataFlowAnalysis::print() does.
+     */
+    void printFunction(raw_ostream &OS, unsigned f) const {
+    	for (const DFAEdgeRecord &edge : getEdges(f)) {
+    		OS << "Edge " << edge.Src << "->" "Edge " << edge.Dst << ":";
+    		printPayload(OS, getKind(), getPayload(edge));
+    	}
+    }
+
+    /*
+     * Print one payload like the print() of the Info it was encoded from.
+     */
+    static void printPayload(raw_ostream &OS, DFAResultKind kind, ArrayRef<uint32_t> words) {
+    	if (kind == DFAResultKind::IndexSet) {
+    		for (unsigned w = 0; w < words.size(); ++w)
+    			for (unsigned bit = 0; bit < 32; ++bit)
+    				if ((words[w] >> bit) & 1)
+    					OS << w * 32 + bit << "|";
+    	} else {
+    		unsigned pos = 0;
+    		printPointsToMap(OS, "R", words, pos);
+    		printPointsToMap(OS, "M", words, pos);
+    	}
+    	OS << "\n";
+    }
+
+  private:
+    const char * Data;
+    size_t Size;
+    const DFAResultHeader * Header;
+
+    bool fits(uint64_t offset, uint64_t size) const {
+    	return offset <= Size && size <= Size - offset;
+    }
+
+    static bool isAligned(uint64_t offset, size_t alignment) {
+    	return offset % alignment == 0;
+    }
+
+    const DFAFunctionRecord & getFunction(unsigned f) const {
+    	return reinterpret_cast<const DFAFunctionRecord *>(Data + Header->FunctionsOffset)[f];
+    }
+
+    static void printPointsToMap(raw_ostream &OS, const char * prefix, ArrayRef<uint32_t> words, unsigned &pos) {
+    	if (pos >= words.size())
+    		return;
+    	unsigned numEntries = words[pos++];
+    	for (unsigned e = 0; e < numEntries && pos + 1 < words.size(); ++e) {
+    		OS << prefix << words[pos] << "->" << "(";
+    		unsigned numPointees = words[pos + 1];
+    		pos += 2;
+    		for (unsigned p = 0; p < numPointees && pos < words.size(); ++p)
+    			OS << "M" << words[pos++] << "/";
+    		OS << ")" << "|";
+    	}
+    }
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_DFARESULT_H
@@ -0,0 +1,105 @@
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Pass.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Module.h"
+#include "231DFA.h"
+#include "LivenessAnalysis.h"
+#include "MemoryLivenessAnalysis.h"
+#include "DFAAliasAnalysis.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+/*
+ * Deletes the instructions without side effects whose value is not live after
+ * them, and the stores to allocas that are not live after them, until neither
+ * analysis finds any. Both analyses are brought up to date incrementally after
+ * every round of deletions.
+ */
+struct DeadCodeEliminationPass : public FunctionPass {
+ 	static char ID;
+  	DeadCodeEliminationPass() : FunctionPass(ID) {}
+
+  	bool runOnFunction(Function &F) override {
+  		EscapePointsTo pointsTo;
+  		pointsTo.analyze(&F);
+  		LivenessInfo bottom;
+  		LivenessAnalysis<LivenessInfo, false> liveness(bottom, bottom);
+  		MemoryLivenessInfo memoryBottom;
+  		MemoryLivenessAnalysis<MemoryLivenessInfo, false> memory(memoryBottom, memoryBottom, pointsTo);
+  		liveness.runWorklistAlgorithm(&F);
+  		memory.runWorklistAlgorithm(&F);
+
+  		unsigned deadInstructions = 0;
+  		unsigned deadStores = 0;
+  		unsigned rounds = 0;
+  		while (true) {
+  			++rounds;
+  			std::vector<Instruction *> dead;
+  			for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+  				if (StoreInst * store = dyn_cast<StoreInst>(&*I)) {
+  					if (memory.isDeadStore(store)) {
+  						dead.push_back(store);
+  						++deadStores;
+  					}
+  				} else if (isRemovable(&*I) && !isLiveAfter(liveness, &*I)) {
+  					dead.push_back(&*I);
+  					++deadInstructions;
+  				}
+  			}
+  			if (dead.empty())
+  				break;
+
+  			// Uses left in code the value never reaches, such as unreachable
+  			// blocks, see undef instead
+  			for (Instruction * I : dead) {
+  				liveness.invalidateInstruction(I);
+  				memory.invalidateInstruction(I);
+  				for (User * user : I->users()) {
+  					liveness.invalidateInstruction(cast<Instruction>(user));
+  					memory.invalidateInstruction(cast<Instruction>(user));
+  				}
+  				I->replaceAllUsesWith(UndefValue::get(I->getType()));
+  			}
+  			for (Instruction * I : dead)
+  				I->eraseFromParent();
+  			liveness.updateWorklistAlgorithm(&F);
+  			memory.updateWorklistAlgorithm(&F);
+  		}
+
+  		errs() << "Function " << F.getName() << ": removed " << deadInstructions << " dead instructions and "
+  		       << deadStores << " dead stores in " << rounds << " rounds\n";
+  		if (DFAPrintStatistics) {
+  			liveness.printStatistics();
+  			memory.printStatistics();
+  		}
+
+  		return deadInstructions + deadStores != 0;
+  	}
+
+  private:
+  	static bool isRemovable(Instruction * I) {
+  		return !I->getType()->isVoidTy() && !I->isTerminator() && !I->isEHPad() && !I->mayHaveSideEffects();
+  	}
+
+  	/*
+  	 * Whether the value of I is live after it. The analysis keeps no live set
+  	 * between the phi nodes of a block, so a phi node is looked up in the one
+  	 * after all of them.
+  	 */
+  	static bool isLiveAfter(LivenessAnalysis<LivenessInfo, false> &liveness, Instruction * I) {
+  		unsigned idx = liveness.getIndexOf(I);
+  		return liveness.anyIncomingInfo(I, [&](const LivenessInfo &info) {
+  			return info.getInfo().contains(idx);
+  		});
+  	}
+}; // end of struct
+}  // end of anonymous namespace
+
+char DeadCodeEliminationPass::ID = 0;
+static RegisterPass<DeadCodeEliminationPass> X("cse231-dce", "dead code and dead store elimination from liveness",
+                             false /* Only looks at CFG */,
+                             false /* Analysis Pass */);
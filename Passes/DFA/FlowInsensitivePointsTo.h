@@ -0,0 +1,694 @@
+//===- FlowInsensitivePointsTo.h - Flow-insensitive may-point-to for CSE 231 DFA -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides two flow-insensitive solvers for the may-point-to
+// analysis. They read the alloca, bitcast, getelementptr, load, store, select
+// and phi instructions of a function as inclusion constraints and compute one
+// points-to solution valid at every program point:
+//
+//   - AndersenPointsTo solves the constraints by inclusion, with difference
+//     propagation and lazy cycle detection.
+//   - SteensgaardPointsTo solves them by unification in near-linear time, at
+//     the cost of merging everything two pointers may both point to.
+//
+// Both are far cheaper than MayPointToAnalysis, which keeps a solution per
+// edge, and less precise. The solution is a MayPointToInfo, printed in the
+// same R/M notation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_FLOWINSENSITIVEPOINTSTO_H
+#define LLVM_TRANSFORMS_231DFA_FLOWINSENSITIVEPOINTSTO_H
+
+#include "231DFA.h"
+#include "MayPointToAnalysis.h"
+#include "PointsToSet.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+// Solver of the may-point-to passes, selected by -cse231-maypointto-solver.
+enum class PointsToSolverKind { FlowSensitive, Andersen, Steensgaard };
+extern cl::opt<PointsToSolverKind> PointsToSolver;
+
+/*
+ * One inclusion constraint between the nodes of a FlowInsensitivePointsTo.
+ *
+ *   AddressOf: pts(Dst) contains the object with id Src
+ *   Copy:      pts(Dst) includes pts(Src)
+ *   Load:      pts(Dst) includes pts(m) for every m in pts(Src)
+ *   Store:     pts(m) includes pts(Src) for every m in pts(Dst)
+ */
+struct PointsToConstraint {
+	enum Kind { AddressOf, Copy, Load, Store };
+	Kind K;
+	unsigned Dst;
+	unsigned Src;
+};
+
+/*
+ * Common part of the flow-insensitive solvers: the constraints of a function,
+ * its instruction indices and the solution.
+ *
+ * Instructions are numbered like DataFlowAnalysis does, from 1 in function
+ * order. The register of instruction i is node 2 * i and the memory of the
+ * alloca i is node 2 * i + 1. Subclasses may add nodes that are not
+ * instructions with newId(), and objects other than the allocas with
+ * newObject(); their ids follow the instruction indices.
+ *
+ * The interface mirrors DataFlowAnalysis, so the passes and the module driver
+ * can run a solver in place of MayPointToAnalysis. The solution holds on every
+ * edge; forEachEdge reports it once, on the edge 0->0.
+ */
+class FlowInsensitivePointsTo {
+  public:
+    typedef MayPointToInfo InfoType;
+
+    FlowInsensitivePointsTo() : Func(nullptr), NumIds(0) {}
+    FlowInsensitivePointsTo(const FlowInsensitivePointsTo &) = delete;
+    FlowInsensitivePointsTo &operator=(const FlowInsensitivePointsTo &) = delete;
+    virtual ~FlowInsensitivePointsTo() {}
+
+    /*
+     * Collect the constraints of func and solve them.
+     */
+    void runWorklistAlgorithm(Function * func) {
+    	Func = func;
+    	Stats = WorklistStatistics();
+    	collectConstraints(func);
+    	solve();
+    	Result = MayPointToInfo(Context, buildMap(false), buildMap(true));
+    }
+
+    void print() {
+    	errs() << "Function " << Func->getName() << ":";
+    	Result.print();
+    }
+
+    template <class Fn>
+    void forEachEdge(Fn fn) {
+    	fn(0u, 0u, &Result);
+    }
+
+    const MayPointToInfo &getResult() const {
+    	return Result;
+    }
+
+    /*
+     * Index of I, or 0 if I is not an instruction of the analyzed function.
+     */
+    unsigned getIndexOf(Instruction * I) const {
+    	auto it = InstrToIndex.find(I);
+    	return it == InstrToIndex.end() ? 0 : it->second;
+    }
+
+    Instruction * getInstrOf(unsigned idx) const {
+    	return idx < IndexToInstr.size() ? IndexToInstr[idx] : nullptr;
+    }
+
+    /*
+     * FlowFunctionCalls counts the nodes visited with new pointees, Joins the
+     * points-to set unions (Andersen) or node unifications (Steensgaard).
+     */
+    const WorklistStatistics &getStatistics() const {
+    	return Stats;
+    }
+
+    void printStatistics() {
+    	errs() << "Constraints: " << Constraints.size() << "\n";
+    	errs() << "Node visits: " << Stats.FlowFunctionCalls << "\n";
+    	errs() << "Worklist pushes: " << Stats.WorklistPushes << "\n";
+    	errs() << "Worklist pops: " << Stats.WorklistPops << "\n";
+    	errs() << "Joins: " << Stats.Joins << "\n";
+    	printSolverStatistics();
+    }
+
+  protected:
+    static unsigned registerNode(unsigned idx) {
+    	return 2 * idx;
+    }
+
+    static unsigned memoryNode(unsigned idx) {
+    	return 2 * idx + 1;
+    }
+
+    unsigned getNumNodes() const {
+    	return 2 * NumIds;
+    }
+
+    unsigned getNumInstructions() const {
+    	return IndexToInstr.size() - 1;
+    }
+
+    Function * getFunction() const {
+    	return Func;
+    }
+
+    unsigned newId() {
+    	return NumIds++;
+    }
+
+    /*
+     * A new object: the pointee of an AddressOf constraint, with a memory node.
+     */
+    unsigned newObject() {
+    	unsigned id = newId();
+    	Objects.push_back(id);
+    	return id;
+    }
+
+    enum : unsigned { NoNode = ~0u };
+
+    /*
+     * The node holding the pointees of the value V, or NoNode if V is not
+     * tracked. Only the instructions of the function are.
+     */
+    virtual unsigned getValueNode(Value * V) {
+    	Instruction * I = dyn_cast<Instruction>(V);
+    	unsigned idx = I ? getIndexOf(I) : 0;
+    	return idx ? registerNode(idx) : NoNode;
+    }
+
+    /*
+     * Add the constraints of I, with index idx, if it is not one of the
+     * instructions handled by every solver.
+     */
+    virtual void collectOtherConstraints(Instruction *, unsigned) {}
+
+    void addConstraint(PointsToConstraint::Kind kind, unsigned dst, unsigned src) {
+    	PointsToConstraint constraint;
+    	constraint.K = kind;
+    	constraint.Dst = dst;
+    	constraint.Src = src;
+    	Constraints.push_back(constraint);
+    }
+
+    /*
+     * Solve Constraints over getNumNodes() nodes.
+     */
+    virtual void solve() = 0;
+
+    /*
+     * The objects node may point to, in increasing id order.
+     */
+    virtual void getPointees(unsigned node, SmallVectorImpl<unsigned> &pointees) = 0;
+
+    virtual void printSolverStatistics() {}
+
+    // Indices of the allocas of the function, in increasing order
+    std::vector<unsigned> Allocas;
+    // Ids of all the objects, the allocas first, in increasing order
+    std::vector<unsigned> Objects;
+    std::vector<PointsToConstraint> Constraints;
+    WorklistStatistics Stats;
+
+  private:
+    void collectConstraints(Function * func) {
+    	InstrToIndex.clear();
+    	IndexToInstr.assign(1, nullptr);
+    	Allocas.clear();
+    	Objects.clear();
+    	Constraints.clear();
+    	for (inst_iterator I = inst_begin(func), E = inst_end(func); I != E; ++I) {
+    		InstrToIndex[&*I] = IndexToInstr.size();
+    		IndexToInstr.push_back(&*I);
+    		if (isa<AllocaInst>(*I)) {
+    			Allocas.push_back(IndexToInstr.size() - 1);
+    			Objects.push_back(IndexToInstr.size() - 1);
+    		}
+    	}
+    	NumIds = IndexToInstr.size();
+
+    	for (unsigned idx = 1; idx < IndexToInstr.size(); ++idx) {
+    		Instruction * I = IndexToInstr[idx];
+    		switch (I->getOpcode()) {
+    		case Instruction::Alloca:
+    			addConstraint(PointsToConstraint::AddressOf, registerNode(idx), idx);
+    			break;
+    		case Instruction::BitCast:
+    			addCopy(idx, I->getOperand(0));
+    			break;
+    		case Instruction::GetElementPtr:
+    			addCopy(idx, cast<GetElementPtrInst>(I)->getPointerOperand());
+    			break;
+    		case Instruction::Load: {
+    			unsigned pointer = getValueNode(cast<LoadInst>(I)->getPointerOperand());
+    			if (pointer != NoNode)
+    				addConstraint(PointsToConstraint::Load, registerNode(idx), pointer);
+    			break;
+    		}
+    		case Instruction::Store: {
+    			unsigned value = getValueNode(cast<StoreInst>(I)->getValueOperand());
+    			unsigned pointer = getValueNode(cast<StoreInst>(I)->getPointerOperand());
+    			if (value != NoNode && pointer != NoNode)
+    				addConstraint(PointsToConstraint::Store, pointer, value);
+    			break;
+    		}
+    		case Instruction::Select:
+    			addCopy(idx, cast<SelectInst>(I)->getTrueValue());
+    			addCopy(idx, cast<SelectInst>(I)->getFalseValue());
+    			break;
+    		case Instruction::PHI:
+    			for (Value * incoming : cast<PHINode>(I)->incoming_values())
+    				addCopy(idx, incoming);
+    			break;
+    		default:
+    			collectOtherConstraints(I, idx);
+    			break;
+    		}
+    	}
+    }
+
+    void addCopy(unsigned idx, Value * src) {
+    	unsigned srcNode = getValueNode(src);
+    	if (srcNode != NoNode)
+    		addConstraint(PointsToConstraint::Copy, registerNode(idx), srcNode);
+    }
+
+    /*
+     * The register map of the solution, or its memory map if memory is set.
+     * Only the allocas of the function have an index, so other pointees are
+     * left out.
+     */
+    const PointsToMap * buildMap(bool memory) {
+    	SmallVector<PointsToMap::Entry, 64> entries;
+    	SmallVector<unsigned, 16> pointees;
+    	auto addEntry = [&](unsigned idx) {
+    		pointees.clear();
+    		getPointees(memory ? memoryNode(idx) : registerNode(idx), pointees);
+    		pointees.erase(std::lower_bound(pointees.begin(), pointees.end(), (unsigned)IndexToInstr.size()),
+    		               pointees.end());
+    		if (const PointsToSet * set = Context.getSet(pointees))
+    			entries.push_back(std::make_pair(idx, set));
+    	};
+    	if (memory) {
+    		for (unsigned idx : Allocas)
+    			addEntry(idx);
+    	} else {
+    		for (unsigned idx = 1; idx < IndexToInstr.size(); ++idx)
+    			addEntry(idx);
+    	}
+    	return Context.getMap(entries);
+    }
+
+    Function * Func;
+    DenseMap<Instruction *, unsigned> InstrToIndex;
+    std::vector<Instruction *> IndexToInstr;
+    unsigned NumIds;
+    PointsToContext Context;
+    MayPointToInfo Result;
+};
+
+/*
+ * Inclusion-based solver. Copy constraints are the edges of a graph along
+ * which points-to sets flow; load and store constraints add edges as the
+ * pointees of their pointer are found.
+ *
+ * Each node remembers the part of its set it already pushed to its successors
+ * and only pushes the difference when it is visited again. When an edge joins
+ * two nodes with equal sets, the solver looks for a cycle through that edge
+ * (lazy cycle detection) and collapses the nodes of any cycle it finds into
+ * one, since they must end up with the same set.
+ */
+class AndersenPointsTo : public FlowInsensitivePointsTo {
+  public:
+    AndersenPointsTo() : NumCollapsed(0), NumCycleSearches(0) {}
+    // Same signature as DataFlowAnalysis, for the drivers
+    AndersenPointsTo(MayPointToInfo &, MayPointToInfo &) :
+    	NumCollapsed(0), NumCycleSearches(0) {}
+
+  protected:
+    void solve() override {
+    	unsigned numNodes = getNumNodes();
+    	Rep.resize(numNodes);
+    	for (unsigned node = 0; node < numNodes; ++node)
+    		Rep[node] = node;
+    	Pts.assign(numNodes, SparseBitVector<>());
+    	Done.assign(numNodes, SparseBitVector<>());
+    	Succs.assign(numNodes, SparseBitVector<>());
+    	Loads.assign(numNodes, SmallVector<unsigned, 2>());
+    	Stores.assign(numNodes, SmallVector<unsigned, 2>());
+    	InWorklist.assign(numNodes, false);
+    	SearchNumber.assign(numNodes, NotSearched);
+    	OnSearchStack.assign(numNodes, false);
+    	CheckedEdges.clear();
+    	NumCollapsed = NumCycleSearches = 0;
+
+    	for (const PointsToConstraint &constraint : Constraints) {
+    		switch (constraint.K) {
+    		case PointsToConstraint::AddressOf:
+    			Pts[constraint.Dst].set(constraint.Src);
+    			push(constraint.Dst);
+    			break;
+    		case PointsToConstraint::Copy:
+    			if (constraint.Dst != constraint.Src)
+    				Succs[constraint.Src].set(constraint.Dst);
+    			break;
+    		case PointsToConstraint::Load:
+    			Loads[constraint.Src].push_back(constraint.Dst);
+    			break;
+    		case PointsToConstraint::Store:
+    			Stores[constraint.Dst].push_back(constraint.Src);
+    			break;
+    		}
+    	}
+
+    	while (!Worklist.empty()) {
+    		unsigned node = Worklist.front();
+    		Worklist.pop_front();
+    		InWorklist[node] = false;
+    		++Stats.WorklistPops;
+    		if (find(node) == node)
+    			visit(node);
+    	}
+    }
+
+    void getPointees(unsigned node, SmallVectorImpl<unsigned> &pointees) override {
+    	appendElements(Pts[find(node)], pointees);
+    }
+
+    void printSolverStatistics() override {
+    	errs() << "Cycle searches: " << NumCycleSearches << "\n";
+    	errs() << "Nodes collapsed: " << NumCollapsed << "\n";
+    }
+
+  private:
+    /*
+     * Push the pointees node gained since its last visit through its load,
+     * store and copy constraints.
+     */
+    void visit(unsigned node) {
+    	SparseBitVector<> delta = Pts[node];
+    	delta.intersectWithComplement(Done[node]);
+    	if (delta.empty())
+    		return;
+    	Done[node] |= delta;
+    	++Stats.FlowFunctionCalls;
+
+    	for (unsigned pointee : delta) {
+    		unsigned memory = memoryNode(pointee);
+    		for (unsigned dst : Loads[node])
+    			addEdge(memory, dst);
+    		for (unsigned src : Stores[node])
+    			addEdge(src, memory);
+    	}
+
+    	SmallVector<unsigned, 8> searchFrom;
+    	SmallVector<unsigned, 16> succs;
+    	appendElements(Succs[node], succs);
+    	for (unsigned succ : succs) {
+    		succ = find(succ);
+    		if (succ == node)
+    			continue;
+    		if (unionInto(succ, delta))
+    			push(succ);
+    		if (Pts[succ] == Pts[node] && CheckedEdges.insert(std::make_pair(node, succ)).second)
+    			searchFrom.push_back(succ);
+    	}
+    	for (unsigned start : searchFrom)
+    		collapseCycles(find(start));
+    }
+
+    /*
+     * Add the copy edge src -> dst. A new edge carries the whole set of src at
+     * once; later additions follow as differences.
+     */
+    void addEdge(unsigned src, unsigned dst) {
+    	src = find(src);
+    	dst = find(dst);
+    	if (src == dst || !Succs[src].test_and_set(dst))
+    		return;
+    	if (unionInto(dst, Pts[src]))
+    		push(dst);
+    }
+
+    static void appendElements(const SparseBitVector<> &bits, SmallVectorImpl<unsigned> &elements) {
+    	for (unsigned element : bits)
+    		elements.push_back(element);
+    }
+
+    bool unionInto(unsigned node, const SparseBitVector<> &pointees) {
+    	++Stats.Joins;
+    	return Pts[node] |= pointees;
+    }
+
+    void push(unsigned node) {
+    	if (InWorklist[node])
+    		return;
+    	InWorklist[node] = true;
+    	Worklist.push_back(node);
+    	++Stats.WorklistPushes;
+    }
+
+    unsigned find(unsigned node) {
+    	while (Rep[node] != node) {
+    		Rep[node] = Rep[Rep[node]];
+    		node = Rep[node];
+    	}
+    	return node;
+    }
+
+    /*
+     * Collapse every cycle of copy edges reachable from start (Tarjan's
+     * algorithm, iteratively).
+     */
+    void collapseCycles(unsigned start) {
+    	++NumCycleSearches;
+    	std::vector<std::vector<unsigned>> cycles;
+    	// (node, next successor to visit)
+    	std::vector<std::pair<unsigned, SparseBitVector<>::iterator>> dfs;
+
+    	auto enter = [&](unsigned node) {
+    		SearchNumber[node] = SearchOrder.size();
+    		SearchLow.push_back(SearchOrder.size());
+    		SearchOrder.push_back(node);
+    		SearchStack.push_back(node);
+    		OnSearchStack[node] = true;
+    		dfs.push_back(std::make_pair(node, Succs[node].begin()));
+    	};
+
+    	enter(start);
+    	while (!dfs.empty()) {
+    		unsigned node = dfs.back().first;
+    		SparseBitVector<>::iterator &next = dfs.back().second;
+    		if (next != Succs[node].end()) {
+    			unsigned succ = find(*next);
+    			++next;
+    			if (SearchNumber[succ] == NotSearched)
+    				enter(succ);
+    			else if (OnSearchStack[succ])
+    				SearchLow[SearchNumber[node]] = std::min(SearchLow[SearchNumber[node]], SearchNumber[succ]);
+    			continue;
+    		}
+
+    		dfs.pop_back();
+    		unsigned low = SearchLow[SearchNumber[node]];
+    		if (!dfs.empty()) {
+    			unsigned parent = SearchNumber[dfs.back().first];
+    			SearchLow[parent] = std::min(SearchLow[parent], low);
+    		}
+    		if (low != SearchNumber[node])
+    			continue;
+    		std::vector<unsigned> cycle;
+    		unsigned member;
+    		do {
+    			member = SearchStack.pop_back_val();
+    			OnSearchStack[member] = false;
+    			cycle.push_back(member);
+    		} while (member != node);
+    		if (cycle.size() > 1)
+    			cycles.push_back(std::move(cycle));
+    	}
+
+    	for (unsigned node : SearchOrder)
+    		SearchNumber[node] = NotSearched;
+    	SearchOrder.clear();
+    	SearchLow.clear();
+
+    	for (const std::vector<unsigned> &cycle : cycles) {
+    		unsigned rep = find(cycle.front());
+    		for (unsigned member : cycle)
+    			merge(rep, find(member));
+    		push(rep);
+    	}
+    }
+
+    /*
+     * Merge node into rep. The merged node has only pushed the pointees both
+     * of them had pushed, so it revisits the others.
+     */
+    void merge(unsigned rep, unsigned node) {
+    	if (rep == node)
+    		return;
+    	Rep[node] = rep;
+    	++NumCollapsed;
+    	Pts[rep] |= Pts[node];
+    	Done[rep] &= Done[node];
+    	Succs[rep] |= Succs[node];
+    	Succs[rep].reset(rep);
+    	Loads[rep].append(Loads[node].begin(), Loads[node].end());
+    	Stores[rep].append(Stores[node].begin(), Stores[node].end());
+    	Pts[node].clear();
+    	Done[node].clear();
+    	Succs[node].clear();
+    	Loads[node].clear();
+    	Stores[node].clear();
+    }
+
+    // Union-find parent of each node; a node is a representative if it is its own parent
+    std::vector<unsigned> Rep;
+    std::vector<SparseBitVector<>> Pts;
+    // Part of Pts already pushed through the constraints of the node
+    std::vector<SparseBitVector<>> Done;
+    // Copy edges; the targets may have been merged since the edge was added
+    std::vector<SparseBitVector<>> Succs;
+    // Loads[p]: the nodes including the memory p points to
+    std::vector<SmallVector<unsigned, 2>> Loads;
+    // Stores[p]: the nodes the memory p points to includes
+    std::vector<SmallVector<unsigned, 2>> Stores;
+    std::deque<unsigned> Worklist;
+    std::vector<bool> InWorklist;
+    // Edges that already triggered a cycle search
+    DenseSet<std::pair<unsigned, unsigned>> CheckedEdges;
+    // State of collapseCycles, kept between searches to avoid reallocating it
+    enum : unsigned { NotSearched = ~0u };
+    std::vector<unsigned> SearchNumber;
+    std::vector<unsigned> SearchLow;
+    std::vector<unsigned> SearchOrder;
+    SmallVector<unsigned, 16> SearchStack;
+    std::vector<bool> OnSearchStack;
+    unsigned NumCollapsed;
+    unsigned NumCycleSearches;
+};
+
+/*
+ * Unification-based solver. Every node belongs to an equivalence class that
+ * points to at most one other class; a constraint unifies the classes its two
+ * sides point to, which in turn unifies what those point to. The solution of a
+ * node is every object whose memory is in the class the node points to.
+ */
+class SteensgaardPointsTo : public FlowInsensitivePointsTo {
+  public:
+    SteensgaardPointsTo() {}
+    // Same signature as DataFlowAnalysis, for the drivers
+    SteensgaardPointsTo(MayPointToInfo &, MayPointToInfo &) {}
+
+  protected:
+    void solve() override {
+    	unsigned numNodes = getNumNodes();
+    	Parent.clear();
+    	Rank.clear();
+    	Target.clear();
+    	for (unsigned node = 0; node < numNodes; ++node)
+    		newNode();
+
+    	for (const PointsToConstraint &constraint : Constraints) {
+    		++Stats.FlowFunctionCalls;
+    		switch (constraint.K) {
+    		case PointsToConstraint::AddressOf:
+    			unify(targetOf(constraint.Dst), memoryNode(constraint.Src));
+    			break;
+    		case PointsToConstraint::Copy:
+    			unify(targetOf(constraint.Dst), targetOf(constraint.Src));
+    			break;
+    		case PointsToConstraint::Load:
+    			unify(targetOf(constraint.Dst), targetOf(targetOf(constraint.Src)));
+    			break;
+    		case PointsToConstraint::Store:
+    			unify(targetOf(targetOf(constraint.Dst)), targetOf(constraint.Src));
+    			break;
+    		}
+    	}
+
+    	ClassObjects.clear();
+    	for (unsigned id : Objects)
+    		ClassObjects[find(memoryNode(id))].push_back(id);
+    }
+
+    void getPointees(unsigned node, SmallVectorImpl<unsigned> &pointees) override {
+    	unsigned target = Target[find(node)];
+    	if (target == NoTarget)
+    		return;
+    	auto it = ClassObjects.find(find(target));
+    	if (it != ClassObjects.end())
+    		pointees.append(it->second.begin(), it->second.end());
+    }
+
+  private:
+    enum : unsigned { NoTarget = ~0u };
+
+    unsigned newNode() {
+    	Parent.push_back(Parent.size());
+    	Rank.push_back(0);
+    	Target.push_back(NoTarget);
+    	return Parent.size() - 1;
+    }
+
+    unsigned find(unsigned node) {
+    	while (Parent[node] != node) {
+    		Parent[node] = Parent[Parent[node]];
+    		node = Parent[node];
+    	}
+    	return node;
+    }
+
+    /*
+     * The class node points to, created empty if it has none yet.
+     */
+    unsigned targetOf(unsigned node) {
+    	node = find(node);
+    	if (Target[node] == NoTarget) {
+    		unsigned target = newNode();
+    		Target[node] = target;
+    	}
+    	return find(Target[node]);
+    }
+
+    void unify(unsigned a, unsigned b) {
+    	SmallVector<std::pair<unsigned, unsigned>, 8> pending;
+    	pending.push_back(std::make_pair(a, b));
+    	while (!pending.empty()) {
+    		std::pair<unsigned, unsigned> pair = pending.pop_back_val();
+    		unsigned x = find(pair.first), y = find(pair.second);
+    		if (x == y)
+    			continue;
+    		++Stats.Joins;
+    		if (Rank[x] < Rank[y])
+    			std::swap(x, y);
+    		if (Rank[x] == Rank[y])
+    			++Rank[x];
+    		Parent[y] = x;
+    		if (Target[x] == NoTarget)
+    			Target[x] = Target[y];
+    		else if (Target[y] != NoTarget)
+    			pending.push_back(std::make_pair(Target[x], Target[y]));
+    	}
+    }
+
+    std::vector<unsigned> Parent;
+    std::vector<unsigned> Rank;
+    // Class each class points to, or NoTarget
+    std::vector<unsigned> Target;
+    // Objects whose memory node is in each class, in increasing id order
+    DenseMap<unsigned, SmallVector<unsigned, 4>> ClassObjects;
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_FLOWINSENSITIVEPOINTSTO_H
@@ -0,0 +1,361 @@
+//===- IndexSetInfo.h - Dense bit-vector lattice for CSE 231 DFA ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides a word-packed set of instruction indices and the lattice
+// elements built on it, shared by the analyses whose information is a set of
+// instruction indices: joined by union (reaching definitions, liveness) or by
+// intersection (available expressions).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_INDEXSETINFO_H
+#define LLVM_TRANSFORMS_231DFA_INDEXSETINFO_H
+
+#include "231DFA.h"
+#include "DFAResult.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * A set of instruction indices stored as a bit vector.
+ * The universe is the dense index space produced by assignIndiceToInstrs,
+ * so the set grows on demand and never needs more than one bit per instruction.
+ * All bulk operations are plain loops over 64-bit words, which the compiler
+ * turns into vector instructions.
+ */
+class DenseIndexSet {
+  public:
+    typedef uint64_t Word;
+    static const unsigned BitsPerWord = 64;
+
+    DenseIndexSet() {}
+
+    /*
+     * Make room for indices in [0, universe) so later inserts do not reallocate.
+     */
+    void reserve(unsigned universe) {
+    	unsigned numWords = (universe + BitsPerWord - 1) / BitsPerWord;
+    	if (numWords > Words.size())
+    		Words.resize(numWords, 0);
+    }
+
+    bool contains(unsigned idx) const {
+    	unsigned w = idx / BitsPerWord;
+    	return w < Words.size() && (Words[w] >> (idx % BitsPerWord)) & 1;
+    }
+
+    void insert(unsigned idx) {
+    	reserve(idx + 1);
+    	Words[idx / BitsPerWord] |= Word(1) << (idx % BitsPerWord);
+    }
+
+    void erase(unsigned idx) {
+    	unsigned w = idx / BitsPerWord;
+    	if (w < Words.size())
+    		Words[w] &= ~(Word(1) << (idx % BitsPerWord));
+    }
+
+    void clear() {
+    	std::fill(Words.begin(), Words.end(), 0);
+    }
+
+    bool empty() const {
+    	for (Word w : Words)
+    		if (w)
+    			return false;
+    	return true;
+    }
+
+    unsigned size() const {
+    	unsigned count = 0;
+    	for (Word w : Words)
+    		count += countPopulation(w);
+    	return count;
+    }
+
+    /*
+     * this |= other. Returns true if this set changed.
+     */
+    bool unionWith(const DenseIndexSet &other) {
+    	if (other.Words.size() > Words.size())
+    		Words.resize(other.Words.size(), 0);
+    	Word *dst = Words.data();
+    	const Word *src = other.Words.data();
+    	Word changed = 0;
+    	for (size_t i = 0, e = other.Words.size(); i != e; ++i) {
+    		changed |= src[i] & ~dst[i];
+    		dst[i] |= src[i];
+    	}
+    	return changed != 0;
+    }
+
+    /*
+     * this &= other. Returns true if this set changed.
+     */
+    bool intersectWith(const DenseIndexSet &other) {
+    	Word *dst = Words.data();
+    	const Word *src = other.Words.data();
+    	size_t common = std::min(Words.size(), other.Words.size());
+    	Word changed = 0;
+    	for (size_t i = 0; i != common; ++i) {
+    		changed |= dst[i] & ~src[i];
+    		dst[i] &= src[i];
+    	}
+    	for (size_t i = common, e = Words.size(); i != e; ++i) {
+    		changed |= dst[i];
+    		dst[i] = 0;
+    	}
+    	return changed != 0;
+    }
+
+    /*
+     * Two sets are equal when they hold the same indices, regardless of
+     * how many trailing zero words either of them has allocated.
+     */
+    bool operator==(const DenseIndexSet &other) const {
+    	const DenseIndexSet &shorter = Words.size() <= other.Words.size() ? *this : other;
+    	const DenseIndexSet &longer = Words.size() <= other.Words.size() ? other : *this;
+    	const Word *a = shorter.Words.data();
+    	const Word *b = longer.Words.data();
+    	Word diff = 0;
+    	for (size_t i = 0, e = shorter.Words.size(); i != e; ++i)
+    		diff |= a[i] ^ b[i];
+    	for (size_t i = shorter.Words.size(), e = longer.Words.size(); i != e; ++i)
+    		diff |= b[i];
+    	return diff == 0;
+    }
+
+    bool operator!=(const DenseIndexSet &other) const {
+    	return !(*this == other);
+    }
+
+    /*
+     * Call fn(idx) for every index in the set, in increasing order.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+    	for (size_t w = 0, e = Words.size(); w != e; ++w) {
+    		Word bits = Words[w];
+    		while (bits) {
+    			fn(unsigned(w * BitsPerWord + countTrailingZeros(bits)));
+    			bits &= bits - 1;
+    		}
+    	}
+    }
+
+    /*
+     * Move every index to its new position in mapping and drop the deleted ones.
+     * Each run of the mapping is copied a word at a time.
+     */
+    void remap(const DFAIndexRemapping &mapping) {
+    	std::vector<Word> remapped;
+    	unsigned numBits = Words.size() * BitsPerWord;
+    	for (const DFAIndexRemapping::Range &range : mapping.Ranges) {
+    		if (range.OldFirst >= numBits)
+    			break;
+    		unsigned length = std::min(range.Length, numBits - range.OldFirst);
+    		for (unsigned done = 0; done < length; done += BitsPerWord) {
+    			unsigned count = std::min(BitsPerWord, length - done);
+    			Word bits = extractBits(range.OldFirst + done, count);
+    			if (bits)
+    				depositBits(remapped, range.NewFirst + done, count, bits);
+    		}
+    	}
+    	Words.swap(remapped);
+    }
+
+  private:
+    std::vector<Word> Words;
+
+    /*
+     * The count bits starting at index pos, as the low bits of a word.
+     */
+    Word extractBits(unsigned pos, unsigned count) const {
+    	unsigned w = pos / BitsPerWord, offset = pos % BitsPerWord;
+    	Word bits = Words[w] >> offset;
+    	if (offset && w + 1 < Words.size())
+    		bits |= Words[w + 1] << (BitsPerWord - offset);
+    	if (count < BitsPerWord)
+    		bits &= (Word(1) << count) - 1;
+    	return bits;
+    }
+
+    /*
+     * Or the count low bits of bits into words, starting at index pos.
+     */
+    static void depositBits(std::vector<Word> &words, unsigned pos, unsigned count, Word bits) {
+    	unsigned w = pos / BitsPerWord, offset = pos % BitsPerWord;
+    	unsigned needed = (pos + count + BitsPerWord - 1) / BitsPerWord;
+    	if (words.size() < needed)
+    		words.resize(needed, 0);
+    	words[w] |= bits << offset;
+    	if (offset && offset + count > BitsPerWord)
+    		words[w + 1] |= bits >> (BitsPerWord - offset);
+    }
+};
+
+/*
+ * A lattice element that is a set of instruction indices.
+ * Derived is the concrete Info class (CRTP).
+ * The order is set inclusion and join is set union.
+ */
+template <class Derived>
+class IndexSetInfo : public Info {
+  public:
+    IndexSetInfo() {}
+    IndexSetInfo(unsigned index) {
+    	Indices.insert(index);
+    }
+    IndexSetInfo(const IndexSetInfo &other) : Info(other), Indices(other.Indices) {}
+    IndexSetInfo &operator=(const IndexSetInfo &) = default;
+
+    /*
+     * Print the indices in increasing order, each followed by "|".
+     */
+    void print() {
+    	Indices.forEach([](unsigned idx) { errs() << idx << "|"; });
+    	errs() << "\n";
+    }
+
+    static bool equals(Info * info1, Info * info2) {
+    	return ((Derived *)info1)->Indices == ((Derived *)info2)->Indices;
+    }
+
+    static bool joinInto(Info * dst, Info * src) {
+    	return ((Derived *)dst)->Indices.unionWith(((Derived *)src)->Indices);
+    }
+
+    void insert(unsigned idx) {
+    	Indices.insert(idx);
+    }
+
+    void remove(unsigned idx) {
+    	Indices.erase(idx);
+    }
+
+    const DenseIndexSet &getInfo() const {
+    	return Indices;
+    }
+
+    void remap(const DFAIndexRemapping &mapping) {
+    	Indices.remap(mapping);
+    }
+
+    static const DFAResultKind ResultKind = DFAResultKind::IndexSet;
+
+    /*
+     * Append the set to words as a bit vector of 32-bit words, without trailing zero words.
+     */
+    void encode(std::vector<uint32_t> &words) const {
+    	size_t start = words.size();
+    	Indices.forEach([&](unsigned idx) {
+    		size_t w = start + idx / 32;
+    		if (words.size() <= w)
+    			words.resize(w + 1, 0);
+    		words[w] |= uint32_t(1) << (idx % 32);
+    	});
+    }
+
+  protected:
+    DenseIndexSet Indices;
+};
+
+/*
+ * A lattice element of a must analysis: a set of instruction indices whose join
+ * is set intersection. Its bottom, the identity of the join and the information
+ * every edge starts from, is the set of all indices. That set does not depend on
+ * the function, so it is a flag: pass universe() as the bottom of the analysis.
+ * Derived is the concrete Info class (CRTP).
+ *
+ * The universe stays the universe under insert and remove. It is only left on
+ * the edges no path from the entry reaches, where anything may be assumed.
+ */
+template <class Derived>
+class IntersectionSetInfo : public Info {
+  public:
+    IntersectionSetInfo() : Universe(false) {}
+    IntersectionSetInfo(unsigned index) : Universe(false) {
+    	Indices.insert(index);
+    }
+    IntersectionSetInfo(const IntersectionSetInfo &other) :
+    	Info(other), Indices(other.Indices), Universe(other.Universe) {}
+    IntersectionSetInfo &operator=(const IntersectionSetInfo &) = default;
+
+    static Derived universe() {
+    	Derived info;
+    	info.Universe = true;
+    	return info;
+    }
+
+    /*
+     * Print the indices in increasing order, each followed by "|", or "*" for
+     * the universe.
+     */
+    void print() {
+    	if (Universe)
+    		errs() << "*";
+    	else
+    		Indices.forEach([](unsigned idx) { errs() << idx << "|"; });
+    	errs() << "\n";
+    }
+
+    static bool equals(Info * info1, Info * info2) {
+    	Derived * a = (Derived *)info1;
+    	Derived * b = (Derived *)info2;
+    	return a->Universe == b->Universe && (a->Universe || a->Indices == b->Indices);
+    }
+
+    static bool joinInto(Info * dst, Info * src) {
+    	Derived * d = (Derived *)dst;
+    	Derived * s = (Derived *)src;
+    	if (s->Universe)
+    		return false;
+    	if (d->Universe) {
+    		d->Universe = false;
+    		d->Indices = s->Indices;
+    		return true;
+    	}
+    	return d->Indices.intersectWith(s->Indices);
+    }
+
+    void insert(unsigned idx) {
+    	if (!Universe)
+    		Indices.insert(idx);
+    }
+
+    void remove(unsigned idx) {
+    	if (!Universe)
+    		Indices.erase(idx);
+    }
+
+    bool contains(unsigned idx) const {
+    	return Universe || Indices.contains(idx);
+    }
+
+    bool isUniverse() const {
+    	return Universe;
+    }
+
+    void remap(const DFAIndexRemapping &mapping) {
+    	if (!Universe)
+    		Indices.remap(mapping);
+    }
+
+  protected:
+    DenseIndexSet Indices;
+    bool Universe;
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_INDEXSETINFO_H
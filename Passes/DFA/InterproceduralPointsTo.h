@@ -0,0 +1,805 @@
+//===- InterproceduralPointsTo.h - Summary-based may-point-to for CSE 231 DFA -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides a module-level may-point-to analysis that follows
+// pointers through direct calls. Each function is solved once by a
+// flow-insensitive solver of FlowInsensitivePointsTo.h and described to its
+// callers by a PointsToSummary: what it may return, and what it may store in
+// the memory its callers can see (the memory reachable from its arguments and
+// the globals). Call sites apply the summary of their callee.
+//
+// Functions are processed bottom-up over the strongly connected components of
+// the call graph, so every callee outside the component is summarized first.
+// Components whose callees are done run in parallel, and the summaries are
+// cached between runs so unchanged functions are not solved again.
+//
+// Indirect calls and calls to declarations have no effect, as in the
+// intraprocedural analyses.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_INTERPROCEDURALPOINTSTO_H
+#define LLVM_TRANSFORMS_231DFA_INTERPROCEDURALPOINTSTO_H
+
+#include "FlowInsensitivePointsTo.h"
+#include "ParallelDriver.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * A memory object named independently of the function being analyzed:
+ *
+ *   Local: the alloca with index Index in the function Base
+ *   Global: the global variable Base
+ *   Param: the objects argument Index of the summarized function points to on
+ *          entry (Depth 1), the objects their memory points to (Depth 2), and
+ *          so on. The deepest level also stands for everything below it.
+ */
+struct PointsToObject {
+	enum Kind { Local, Global, Param };
+	Kind K;
+	const Value * Base;
+	unsigned Index;
+	unsigned Depth;
+
+	static PointsToObject local(const Function * F, unsigned idx) {
+		PointsToObject object = {Local, F, idx, 0};
+		return object;
+	}
+
+	static PointsToObject global(const GlobalVariable * G) {
+		PointsToObject object = {Global, G, 0, 0};
+		return object;
+	}
+
+	static PointsToObject param(unsigned argNo, unsigned depth) {
+		PointsToObject object = {Param, nullptr, argNo, depth};
+		return object;
+	}
+
+	bool operator==(const PointsToObject &other) const {
+		return K == other.K && Base == other.Base && Index == other.Index && Depth == other.Depth;
+	}
+
+	/*
+	 * Ordered by name rather than address, so the printed results do not
+	 * change from run to run.
+	 */
+	bool operator<(const PointsToObject &other) const {
+		StringRef name = Base ? Base->getName() : StringRef();
+		StringRef otherName = other.Base ? other.Base->getName() : StringRef();
+		return std::make_tuple(K, name, Index, Depth, Base) <
+		       std::make_tuple(other.K, otherName, other.Index, other.Depth, other.Base);
+	}
+
+	/*
+	 * Print in the R/M notation: the allocas of current as M<index>, the other
+	 * allocas as M<function>.<index>, globals as M@<name> and the parameter
+	 * objects as M%<argument>.<depth>.
+	 */
+	void print(raw_ostream &OS, const Function * current) const {
+		OS << "M";
+		switch (K) {
+		case Local:
+			if (Base != current)
+				OS << Base->getName() << ".";
+			OS << Index;
+			break;
+		case Global:
+			OS << "@" << Base->getName();
+			break;
+		case Param:
+			OS << "%" << Index << "." << Depth;
+			break;
+		}
+	}
+};
+
+inline hash_code hash_value(const PointsToObject &object) {
+	return hash_combine(object.K, object.Base, object.Index, object.Depth);
+}
+
+/*
+ * Effect of a function on the pointers of its callers. Object sets are sorted
+ * and hold no duplicates.
+ */
+struct PointsToSummary {
+	typedef std::vector<PointsToObject> ObjectSet;
+
+	// Objects the return value may point to
+	ObjectSet Return;
+	// Objects the memory of each visible object may point to after the call,
+	// sorted by object. A parameter object is not listed as pointing to the
+	// next deeper one, which it does by definition.
+	std::vector<std::pair<PointsToObject, ObjectSet>> Memory;
+
+	bool operator==(const PointsToSummary &other) const {
+		return Return == other.Return && Memory == other.Memory;
+	}
+
+	bool operator!=(const PointsToSummary &other) const {
+		return !(*this == other);
+	}
+
+	hash_code hash() const {
+		hash_code memory = hash_value(Memory.size());
+		for (const auto &entry : Memory)
+			memory = hash_combine(memory, entry.first, hash_combine_range(entry.second.begin(), entry.second.end()));
+		return hash_combine(hash_combine_range(Return.begin(), Return.end()), memory);
+	}
+
+	void print(raw_ostream &OS, const Function * current) const {
+		if (!Return.empty()) {
+			OS << "ret->";
+			printSet(OS, Return, current);
+		}
+		for (const auto &entry : Memory) {
+			entry.first.print(OS, current);
+			OS << "->";
+			printSet(OS, entry.second, current);
+		}
+	}
+
+	static void printSet(raw_ostream &OS, const ObjectSet &objects, const Function * current) {
+		OS << "(";
+		for (const PointsToObject &object : objects) {
+			object.print(OS, current);
+			OS << "/";
+		}
+		OS << ")|";
+	}
+};
+
+/*
+ * Solver of one function that applies the summaries of its callees and
+ * summarizes it in turn.
+ *
+ * Each pointer argument i points to the object Param(i, 1), whose memory
+ * points to Param(i, 2), down to ParamDepth. At a call site, Param(i, 1) of
+ * the callee stands for the pointees of the actual argument, Param(i, 2) for
+ * what their memory points to, and so on.
+ */
+template <class SolverT>
+class FunctionSummaryBuilder : public SolverT {
+  public:
+    typedef DenseMap<const Function *, const PointsToSummary *> SummaryMap;
+
+    enum : unsigned { ParamDepth = 2 };
+
+    /*
+     * summaries holds the summary of every callee, or nullptr for the callees
+     * that have none yet.
+     */
+    explicit FunctionSummaryBuilder(const SummaryMap &summaries) : Summaries(summaries), ReturnNode(NoNode) {}
+
+    /*
+     * Solve F with the current summaries of its callees and rebuild its summary.
+     */
+    void analyze(Function * F) {
+    	ArgNodes.clear();
+    	AddressNodes.clear();
+    	ObjectIds.clear();
+    	IdObjects.clear();
+    	Callees.clear();
+    	ReturnNode = NoNode;
+    	this->runWorklistAlgorithm(F);
+    	buildSummary();
+    }
+
+    const PointsToSummary &getSummary() const {
+    	return Summary;
+    }
+
+    /*
+     * The callees whose summary was applied, in no particular order.
+     */
+    const std::vector<const Function *> &getCallees() const {
+    	return Callees;
+    }
+
+    /*
+     * Print the registers and allocas of the function, then its summary.
+     */
+    void print() {
+    	Function * F = this->getFunction();
+    	errs() << "Function " << F->getName() << ":";
+    	for (unsigned idx = 1; idx <= this->getNumInstructions(); ++idx)
+    		printNode("R", idx, registerNode(idx));
+    	for (unsigned idx : this->Allocas)
+    		printNode("M", idx, memoryNode(idx));
+    	errs() << "\n";
+    	errs() << "Summary " << F->getName() << ":";
+    	Summary.print(errs(), F);
+    	errs() << "\n";
+    }
+
+  protected:
+    using SolverT::NoNode;
+    using SolverT::registerNode;
+    using SolverT::memoryNode;
+
+    /*
+     * Arguments and globals are tracked too, through the nodes that point to
+     * their objects.
+     */
+    unsigned getValueNode(Value * V) override {
+    	if (isa<Instruction>(V))
+    		return SolverT::getValueNode(V);
+    	V = V->stripPointerCasts();
+    	if (Argument * A = dyn_cast<Argument>(V))
+    		return A->getType()->isPointerTy() ? getArgNode(A->getArgNo()) : NoNode;
+    	if (GlobalVariable * G = dyn_cast<GlobalVariable>(V))
+    		return getAddressNode(getObjectId(PointsToObject::global(G)));
+    	return NoNode;
+    }
+
+    void collectOtherConstraints(Instruction * I, unsigned idx) override {
+    	if (ReturnInst * ret = dyn_cast<ReturnInst>(I)) {
+    		unsigned value = ret->getReturnValue() ? getValueNode(ret->getReturnValue()) : NoNode;
+    		if (value != NoNode)
+    			this->addConstraint(PointsToConstraint::Copy, getReturnNode(), value);
+    	} else if (CallInst * call = dyn_cast<CallInst>(I)) {
+    		applySummary(call, idx);
+    	} else if (InvokeInst * invoke = dyn_cast<InvokeInst>(I)) {
+    		applySummary(invoke, idx);
+    	}
+    }
+
+  private:
+    unsigned getArgNode(unsigned argNo) {
+    	auto it = ArgNodes.find(argNo);
+    	if (it != ArgNodes.end())
+    		return it->second;
+    	unsigned node = registerNode(this->newId());
+    	this->addConstraint(PointsToConstraint::AddressOf, node, getObjectId(PointsToObject::param(argNo, 1)));
+    	ArgNodes[argNo] = node;
+    	return node;
+    }
+
+    /*
+     * A node pointing to exactly the object id.
+     */
+    unsigned getAddressNode(unsigned id) {
+    	auto it = AddressNodes.find(id);
+    	if (it != AddressNodes.end())
+    		return it->second;
+    	unsigned node = registerNode(this->newId());
+    	this->addConstraint(PointsToConstraint::AddressOf, node, id);
+    	AddressNodes[id] = node;
+    	return node;
+    }
+
+    unsigned getReturnNode() {
+    	if (ReturnNode == NoNode)
+    		ReturnNode = registerNode(this->newId());
+    	return ReturnNode;
+    }
+
+    /*
+     * The id of object in this function, created on first use. The memory of a
+     * new global points to the global its initializer points to, if any; a new
+     * parameter object comes with the chain below it.
+     */
+    unsigned getObjectId(const PointsToObject &object) {
+    	if (object.K == PointsToObject::Local && object.Base == this->getFunction())
+    		return object.Index;
+    	auto it = ObjectIds.find(object);
+    	if (it != ObjectIds.end())
+    		return it->second;
+
+    	if (object.K == PointsToObject::Param) {
+    		unsigned above = 0;
+    		for (unsigned depth = 1; depth <= ParamDepth; ++depth) {
+    			unsigned id = this->newObject();
+    			ObjectIds[PointsToObject::param(object.Index, depth)] = id;
+    			IdObjects[id] = PointsToObject::param(object.Index, depth);
+    			if (depth > 1)
+    				this->addConstraint(PointsToConstraint::AddressOf, memoryNode(above), id);
+    			above = id;
+    		}
+    		this->addConstraint(PointsToConstraint::AddressOf, memoryNode(above), above);
+    		return ObjectIds[object];
+    	}
+
+    	unsigned id = this->newObject();
+    	ObjectIds[object] = id;
+    	IdObjects[id] = object;
+    	if (object.K == PointsToObject::Global) {
+    		const GlobalVariable * G = cast<GlobalVariable>(object.Base);
+    		if (G->hasInitializer()) {
+    			if (const GlobalVariable * target = dyn_cast<GlobalVariable>(G->getInitializer()->stripPointerCasts()))
+    				this->addConstraint(PointsToConstraint::AddressOf, memoryNode(id),
+    				                    getObjectId(PointsToObject::global(target)));
+    		}
+    	}
+    	return id;
+    }
+
+    PointsToObject getObjectOf(unsigned id) const {
+    	if (id <= this->getNumInstructions())
+    		return PointsToObject::local(this->getFunction(), id);
+    	return IdObjects.find(id)->second;
+    }
+
+    template <class CallT>
+    void applySummary(CallT * call, unsigned idx) {
+    	Function * callee = call->getCalledFunction();
+    	if (!callee || callee->isDeclaration())
+    		return;
+    	auto it = Summaries.find(callee);
+    	if (it == Summaries.end() || !it->second)
+    		return;
+    	const PointsToSummary &summary = *it->second;
+    	Callees.push_back(callee);
+
+    	SmallVector<Value *, 4> actuals(call->arg_operands().begin(), call->arg_operands().end());
+    	// Nodes holding the objects each parameter object of the callee stands for
+    	std::map<std::pair<unsigned, unsigned>, unsigned> paramNodes;
+    	std::function<unsigned(unsigned, unsigned)> getParamNode = [&](unsigned argNo, unsigned depth) {
+    		auto found = paramNodes.find(std::make_pair(argNo, depth));
+    		if (found != paramNodes.end())
+    			return found->second;
+    		unsigned node = registerNode(this->newId());
+    		if (depth == 1) {
+    			unsigned actual = argNo < actuals.size() ? getValueNode(actuals[argNo]) : NoNode;
+    			if (actual != NoNode)
+    				this->addConstraint(PointsToConstraint::Copy, node, actual);
+    		} else {
+    			this->addConstraint(PointsToConstraint::Load, node, getParamNode(argNo, depth - 1));
+    		}
+    		if (depth == ParamDepth)
+    			this->addConstraint(PointsToConstraint::Load, node, node);
+    		paramNodes[std::make_pair(argNo, depth)] = node;
+    		return node;
+    	};
+    	// Make dst include the objects object stands for
+    	auto include = [&](unsigned dst, const PointsToObject &object) {
+    		if (object.K == PointsToObject::Param)
+    			this->addConstraint(PointsToConstraint::Copy, dst, getParamNode(object.Index, object.Depth));
+    		else
+    			this->addConstraint(PointsToConstraint::AddressOf, dst, getObjectId(object));
+    	};
+
+    	for (const PointsToObject &object : summary.Return)
+    		include(registerNode(idx), object);
+    	for (const auto &entry : summary.Memory) {
+    		const PointsToObject &target = entry.first;
+    		if (target.K != PointsToObject::Param) {
+    			unsigned memory = memoryNode(getObjectId(target));
+    			for (const PointsToObject &object : entry.second)
+    				include(memory, object);
+    			continue;
+    		}
+    		unsigned pointer = getParamNode(target.Index, target.Depth);
+    		for (const PointsToObject &object : entry.second) {
+    			unsigned value = registerNode(this->newId());
+    			include(value, object);
+    			this->addConstraint(PointsToConstraint::Store, pointer, value);
+    		}
+    	}
+    }
+
+    void getObjects(unsigned node, SmallVectorImpl<unsigned> &ids, PointsToSummary::ObjectSet &objects) {
+    	ids.clear();
+    	this->getPointees(node, ids);
+    	objects.clear();
+    	for (unsigned id : ids)
+    		objects.push_back(getObjectOf(id));
+    	std::sort(objects.begin(), objects.end());
+    }
+
+    /*
+     * The summary lists the return value and the memory of every object the
+     * callers can reach: the parameter objects, the globals, and whatever
+     * those or the return value point to.
+     */
+    void buildSummary() {
+    	Summary = PointsToSummary();
+    	SmallVector<unsigned, 16> ids;
+    	if (ReturnNode != NoNode)
+    		getObjects(ReturnNode, ids, Summary.Return);
+
+    	std::vector<unsigned> worklist;
+    	DenseSet<unsigned> visible;
+    	for (const auto &entry : IdObjects) {
+    		if (entry.second.K != PointsToObject::Local && visible.insert(entry.first).second)
+    			worklist.push_back(entry.first);
+    	}
+    	if (ReturnNode != NoNode) {
+    		ids.clear();
+    		this->getPointees(ReturnNode, ids);
+    		for (unsigned id : ids) {
+    			if (visible.insert(id).second)
+    				worklist.push_back(id);
+    		}
+    	}
+
+    	PointsToSummary::ObjectSet objects;
+    	while (!worklist.empty()) {
+    		unsigned id = worklist.back();
+    		worklist.pop_back();
+    		getObjects(memoryNode(id), ids, objects);
+    		for (unsigned pointee : ids) {
+    			if (visible.insert(pointee).second)
+    				worklist.push_back(pointee);
+    		}
+    		PointsToObject object = getObjectOf(id);
+    		if (object.K == PointsToObject::Param) {
+    			PointsToObject next = PointsToObject::param(object.Index, std::min<unsigned>(object.Depth + 1, ParamDepth));
+    			objects.erase(std::remove(objects.begin(), objects.end(), next), objects.end());
+    		}
+    		if (!objects.empty())
+    			Summary.Memory.push_back(std::make_pair(object, objects));
+    	}
+    	std::sort(Summary.Memory.begin(), Summary.Memory.end(),
+    	          [](const std::pair<PointsToObject, PointsToSummary::ObjectSet> &a,
+    	             const std::pair<PointsToObject, PointsToSummary::ObjectSet> &b) { return a.first < b.first; });
+    }
+
+    void printNode(const char * prefix, unsigned idx, unsigned node) {
+    	SmallVector<unsigned, 16> ids;
+    	PointsToSummary::ObjectSet objects;
+    	getObjects(node, ids, objects);
+    	if (objects.empty())
+    		return;
+    	errs() << prefix << idx << "->";
+    	PointsToSummary::printSet(errs(), objects, this->getFunction());
+    }
+
+    const SummaryMap &Summaries;
+    PointsToSummary Summary;
+    std::vector<const Function *> Callees;
+    DenseMap<unsigned, unsigned> ArgNodes;
+    DenseMap<unsigned, unsigned> AddressNodes;
+    std::map<PointsToObject, unsigned> ObjectIds;
+    DenseMap<unsigned, PointsToObject> IdObjects;
+    unsigned ReturnNode;
+};
+
+/*
+ * Counters of InterproceduralPointsTo::run, reported by printStatistics
+ */
+struct SummaryStatistics {
+	unsigned Components = 0;
+	unsigned FunctionsSolved = 0;
+	unsigned FunctionsReused = 0;
+	// Rounds over recursive components until their summaries stop changing
+	unsigned RecursiveRounds = 0;
+};
+
+/*
+ * Bottom-up driver over the call graph of a module, solving every function
+ * with SolverT. The solved functions are kept between runs: a function is
+ * solved again only if its body or the summary of one of its callees changed.
+ * Functions deleted or replaced by another one at the same address between
+ * runs must be passed to invalidate().
+ */
+template <class SolverT>
+class InterproceduralPointsTo {
+  public:
+    typedef FunctionSummaryBuilder<SolverT> BuilderT;
+
+    InterproceduralPointsTo() {}
+    InterproceduralPointsTo(const InterproceduralPointsTo &) = delete;
+    InterproceduralPointsTo &operator=(const InterproceduralPointsTo &) = delete;
+
+    void run(Module &M) {
+    	Stats = SummaryStatistics();
+    	Functions.clear();
+    	Summaries.clear();
+    	DenseSet<const Function *> defined;
+    	for (Function &F : M) {
+    		if (F.isDeclaration())
+    			continue;
+    		Functions.push_back(&F);
+    		defined.insert(&F);
+    		Summaries[&F] = nullptr;
+    	}
+    	std::vector<const Function *> stale;
+    	for (const auto &entry : Cache) {
+    		if (!defined.count(entry.first))
+    			stale.push_back(entry.first);
+    	}
+    	for (const Function * F : stale)
+    		Cache.erase(F);
+
+    	std::vector<std::vector<Function *>> components;
+    	DenseMap<const Function *, unsigned> componentOf;
+    	CallGraph CG(M);
+    	for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
+    		std::vector<Function *> component;
+    		for (CallGraphNode * node : *I) {
+    			Function * F = node->getFunction();
+    			if (F && !F->isDeclaration()) {
+    				componentOf[F] = components.size();
+    				component.push_back(F);
+    			}
+    		}
+    		if (!component.empty())
+    			components.push_back(std::move(component));
+    	}
+    	Stats.Components = components.size();
+    	if (components.empty())
+    		return;
+
+    	// A component is ready once all the components it calls are done
+    	std::vector<unsigned> pending(components.size(), 0);
+    	std::vector<std::vector<unsigned>> callers(components.size());
+    	for (unsigned c = 0; c < components.size(); ++c) {
+    		DenseSet<unsigned> callees;
+    		for (Function * F : components[c]) {
+    			for (const Function * callee : getDirectCallees(*F)) {
+    				auto it = componentOf.find(callee);
+    				if (it != componentOf.end() && it->second != c && callees.insert(it->second).second) {
+    					++pending[c];
+    					callers[it->second].push_back(c);
+    				}
+    			}
+    		}
+    	}
+
+    	std::mutex mutex;
+    	std::condition_variable changed;
+    	std::vector<unsigned> ready;
+    	for (unsigned c = 0; c < components.size(); ++c) {
+    		if (pending[c] == 0)
+    			ready.push_back(c);
+    	}
+    	unsigned done = 0;
+
+    	auto worker = [&]() {
+    		std::unique_lock<std::mutex> lock(mutex);
+    		while (true) {
+    			changed.wait(lock, [&]() { return !ready.empty() || done == components.size(); });
+    			if (ready.empty())
+    				return;
+    			unsigned c = ready.back();
+    			ready.pop_back();
+    			lock.unlock();
+    			SummaryStatistics stats = analyzeComponent(components[c]);
+    			lock.lock();
+    			Stats.FunctionsSolved += stats.FunctionsSolved;
+    			Stats.FunctionsReused += stats.FunctionsReused;
+    			Stats.RecursiveRounds += stats.RecursiveRounds;
+    			++done;
+    			for (unsigned caller : callers[c]) {
+    				if (--pending[caller] == 0)
+    					ready.push_back(caller);
+    			}
+    			changed.notify_all();
+    		}
+    	};
+
+    	unsigned numThreads = DFAThreads;
+    	if (numThreads == 0)
+    		numThreads = std::max(1u, std::thread::hardware_concurrency());
+    	numThreads = std::min<unsigned>(numThreads, components.size());
+    	std::vector<std::thread> threads;
+    	for (unsigned t = 1; t < numThreads; ++t)
+    		threads.emplace_back(worker);
+    	worker();
+    	for (std::thread &thread : threads)
+    		thread.join();
+    }
+
+    /*
+     * The solved function F of the last run.
+     */
+    BuilderT &getResult(const Function * F) {
+    	return *Cache.find(F)->second.Builder;
+    }
+
+    /*
+     * The defined functions of the module of the last run, in module order.
+     */
+    const std::vector<Function *> &getFunctions() const {
+    	return Functions;
+    }
+
+    void invalidate(const Function * F) {
+    	Cache.erase(F);
+    }
+
+    void clear() {
+    	Cache.clear();
+    }
+
+    const SummaryStatistics &getStatistics() const {
+    	return Stats;
+    }
+
+    void printStatistics() {
+    	errs() << "Call graph components: " << Stats.Components << "\n";
+    	errs() << "Functions solved: " << Stats.FunctionsSolved << "\n";
+    	errs() << "Functions reused: " << Stats.FunctionsReused << "\n";
+    	errs() << "Recursive rounds: " << Stats.RecursiveRounds << "\n";
+    }
+
+  private:
+    struct CacheEntry {
+    	hash_code Fingerprint;
+    	// Hash of the summary of each callee outside the component, when F was solved
+    	std::vector<std::pair<const Function *, hash_code>> Callees;
+    	std::unique_ptr<BuilderT> Builder;
+    };
+
+    static std::vector<const Function *> getDirectCallees(const Function &F) {
+    	std::vector<const Function *> callees;
+    	for (const BasicBlock &BB : F) {
+    		for (const Instruction &I : BB) {
+    			const Function * callee = nullptr;
+    			if (const CallInst * call = dyn_cast<CallInst>(&I))
+    				callee = call->getCalledFunction();
+    			else if (const InvokeInst * invoke = dyn_cast<InvokeInst>(&I))
+    				callee = invoke->getCalledFunction();
+    			if (callee && !callee->isDeclaration())
+    				callees.push_back(callee);
+    		}
+    	}
+    	return callees;
+    }
+
+    /*
+     * Hash of the body of F: the opcode, type and operands of every
+     * instruction, with the instructions, blocks and arguments it refers to
+     * identified by position.
+     */
+    static hash_code getFingerprint(const Function &F) {
+    	DenseMap<const Value *, unsigned> local;
+    	for (const Argument &A : F.args())
+    		local[&A] = local.size();
+    	for (const BasicBlock &BB : F) {
+    		local[&BB] = local.size();
+    		for (const Instruction &I : BB)
+    			local[&I] = local.size();
+    	}
+    	hash_code hash = hash_value(F.getFunctionType());
+    	for (const BasicBlock &BB : F) {
+    		for (const Instruction &I : BB) {
+    			hash = hash_combine(hash, I.getOpcode(), I.getType(), I.getNumOperands());
+    			for (const Value * operand : I.operand_values()) {
+    				auto it = local.find(operand);
+    				hash = it != local.end() ? hash_combine(hash, it->second) : hash_combine(hash, operand);
+    			}
+    		}
+    	}
+    	return hash;
+    }
+
+    bool isRecursive(const std::vector<Function *> &component) {
+    	if (component.size() > 1)
+    		return true;
+    	for (const Function * callee : getDirectCallees(*component.front())) {
+    		if (callee == component.front())
+    			return true;
+    	}
+    	return false;
+    }
+
+    /*
+     * Summarize the functions of a component whose callees outside it are all
+     * summarized. Recursive components are solved again until no summary
+     * changes; their summaries only grow, so this terminates.
+     */
+    SummaryStatistics analyzeComponent(const std::vector<Function *> &component) {
+    	SummaryStatistics stats;
+    	std::vector<hash_code> fingerprints;
+    	bool reuse = true;
+    	for (Function * F : component) {
+    		fingerprints.push_back(getFingerprint(*F));
+    		reuse = reuse && isCached(F, fingerprints.back());
+    	}
+
+    	std::vector<CacheEntry *> entries;
+    	{
+    		std::lock_guard<std::mutex> lock(CacheMutex);
+    		for (Function * F : component)
+    			entries.push_back(&Cache[F]);
+    	}
+    	if (reuse) {
+    		for (unsigned i = 0; i < component.size(); ++i)
+    			publish(component[i], &entries[i]->Builder->getSummary());
+    		stats.FunctionsReused = component.size();
+    		return stats;
+    	}
+
+    	for (unsigned i = 0; i < component.size(); ++i) {
+    		entries[i]->Fingerprint = fingerprints[i];
+    		entries[i]->Builder.reset(new BuilderT(Summaries));
+    		publish(component[i], nullptr);
+    	}
+    	bool recursive = isRecursive(component);
+    	bool summaryChanged = true;
+    	while (summaryChanged) {
+    		summaryChanged = false;
+    		for (unsigned i = 0; i < component.size(); ++i) {
+    			BuilderT &builder = *entries[i]->Builder;
+    			PointsToSummary previous = builder.getSummary();
+    			builder.analyze(component[i]);
+    			++stats.FunctionsSolved;
+    			if (Summaries.find(component[i])->second == nullptr || builder.getSummary() != previous)
+    				summaryChanged = true;
+    			publish(component[i], &builder.getSummary());
+    		}
+    		if (!recursive)
+    			break;
+    		++stats.RecursiveRounds;
+    	}
+
+    	for (unsigned i = 0; i < component.size(); ++i) {
+    		entries[i]->Callees.clear();
+    		for (const Function * callee : entries[i]->Builder->getCallees()) {
+    			if (std::find(component.begin(), component.end(), callee) == component.end())
+    				entries[i]->Callees.push_back(std::make_pair(callee, Summaries.find(callee)->second->hash()));
+    		}
+    	}
+    	return stats;
+    }
+
+    /*
+     * Whether the cached solution of F still holds: same body, and the callees
+     * it applied still have the same summary.
+     */
+    bool isCached(const Function * F, hash_code fingerprint) {
+    	const CacheEntry * entry;
+    	{
+    		std::lock_guard<std::mutex> lock(CacheMutex);
+    		auto it = Cache.find(F);
+    		if (it == Cache.end() || !it->second.Builder)
+    			return false;
+    		entry = &it->second;
+    	}
+    	if (entry->Fingerprint != fingerprint)
+    		return false;
+    	for (const auto &callee : entry->Callees) {
+    		auto it = Summaries.find(callee.first);
+    		if (it == Summaries.end() || !it->second || it->second->hash() != callee.second)
+    			return false;
+    	}
+    	return true;
+    }
+
+    /*
+     * Set the summary of F seen by its callers. Summaries holds an entry for
+     * every function from the start of the run, so this only writes the value
+     * of an existing entry and never moves the others under concurrent readers.
+     */
+    void publish(const Function * F, const PointsToSummary * summary) {
+    	Summaries.find(F)->second = summary;
+    }
+
+    std::vector<Function *> Functions;
+    typename BuilderT::SummaryMap Summaries;
+    // std::map so entries stay in place while other threads insert
+    std::map<const Function *, CacheEntry> Cache;
+    std::mutex CacheMutex;
+    SummaryStatistics Stats;
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_INTERPROCEDURALPOINTSTO_H
@@ -0,0 +1,300 @@
+//===- LivenessAnalysis.h - Liveness analysis for CSE 231 DFA ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the lattice and the flow function of the liveness analysis,
+// and a sparse solver that computes the same result from def-use chains.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_LIVENESSANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_LIVENESSANALYSIS_H
+
+#include "231DFA.h"
+#include "IndexSetInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/CFG.h"
+#include <algorithm>
+#include <vector>
+
+namespace llvm {
+
+class LivenessInfo : public IndexSetInfo<LivenessInfo> {
+public:
+	LivenessInfo() {}
+	LivenessInfo(unsigned index) : IndexSetInfo<LivenessInfo>(index) {}
+	LivenessInfo(const LivenessInfo& other) : IndexSetInfo<LivenessInfo>(other) {}
+	LivenessInfo& operator=(const LivenessInfo&) = default;
+};
+
+template <class Info, bool Direction>
+class LivenessAnalysis : public DataFlowAnalysis<Info, Direction> {
+public:
+	LivenessAnalysis(LivenessInfo &bottom, LivenessInfo &initialState) : 
+		DataFlowAnalysis<Info, Direction>::DataFlowAnalysis(bottom, initialState){}
+
+	/*
+	 * The effect of a non-phi instruction on the set of values live below it.
+	 */
+	void transfer(Instruction * I, Info * info) {
+		if(isDefiningInstr(I)){
+			info->remove(this->InstrToIndex[I]);
+		}
+		for(Use &U : I->operands()){
+			Instruction *inst = (Instruction*) U.get();
+			if(this->InstrToIndex.find(inst) != this->InstrToIndex.end()){
+				unsigned operand_idx = this->InstrToIndex[cast<Instruction>(inst)];
+				info->insert(operand_idx);
+			}
+		}
+	}
+
+	/*
+	 * Remove the phi nodes starting at I, the first phi node of a block.
+	 */
+	void removePhis(Instruction * I, Info * info) {
+		while(isa<PHINode>(I)){
+			info->remove(this->InstrToIndex[I]);
+			I = I->getNextNode();
+		}
+	}
+
+	/*
+	 * Add the values that the phi nodes starting at I take when control comes from pred.
+	 */
+	void addPhiUses(Instruction * I, BasicBlock * pred, Info * info) {
+		while(isa<PHINode>(I)){
+			PHINode* phi_inst = (PHINode*) I;
+			for(unsigned i = 0; i<phi_inst->getNumIncomingValues(); i++){
+				if(phi_inst->getIncomingBlock(i) != pred ||
+					this->InstrToIndex.find((Instruction*)(phi_inst->getIncomingValue(i))) == this->InstrToIndex.end()){
+					continue;
+				}
+				info->insert(this->InstrToIndex[(Instruction*)(phi_inst->getIncomingValue(i))]);
+			}
+			I = I->getNextNode();
+		}
+	}
+
+	void flowfunction(Instruction * I,
+    									std::vector<unsigned> & IncomingEdges,
+										std::vector<unsigned> & OutgoingEdges,
+										std::vector<Info *> & Infos) {
+
+		unsigned idx = this->InstrToIndex[I];
+		Info *combineInfo = this->joinIncoming(idx);
+		if(isa<PHINode>(I)){
+			removePhis(I, combineInfo);
+			for(unsigned j=0; j<OutgoingEdges.size(); ++j){
+				Infos.push_back(this->allocateInfo(*combineInfo));
+				addPhiUses(I, this->IndexToInstr[OutgoingEdges[j]]->getParent(), Infos[j]);
+			}
+			this->releaseInfo(combineInfo);
+		}
+		else{
+			transfer(I, combineInfo);
+			this->shareOutgoingInfo(combineInfo, OutgoingEdges.size(), Infos);
+		}
+	}
+};
+
+/*
+ * Liveness computed from def-use chains instead of per-edge sets.
+ *
+ * Every use of a value is walked backwards through the CFG until the definition
+ * kills it, which gives the values live into and out of each basic block. The
+ * information of an edge is only built when print() or getEdgeInfo() asks for it,
+ * by replaying the flow function of LivenessAnalysis inside one block, so memory
+ * grows with the live ranges instead of with edges times values. The results are
+ * the same as the ones of LivenessAnalysis.
+ */
+class SparseLivenessAnalysis : public LivenessAnalysis<LivenessInfo, false> {
+public:
+	SparseLivenessAnalysis(LivenessInfo &bottom, LivenessInfo &initialState) :
+		LivenessAnalysis<LivenessInfo, false>(bottom, initialState){}
+
+	void runWorklistAlgorithm(Function * func) {
+		clearMap();
+		ChangedBlocks.clear();
+		Blocks.clear();
+		BlockNumber.clear();
+		initializeBackwardMap(func);
+
+		for(BasicBlock &BB : *func){
+			BlockNumber[&BB] = Blocks.size();
+			Blocks.push_back(&BB);
+		}
+		LiveIn.assign(Blocks.size(), std::vector<unsigned>());
+		LiveOut.assign(Blocks.size(), std::vector<unsigned>());
+
+		// Values are visited in increasing index order, so every list stays sorted and
+		// its last element tells whether the current value is already in it.
+		for(unsigned idx = 1; idx < IndexToInstr.size(); ++idx){
+			Instruction * def = IndexToInstr[idx];
+			for(User * user : def->users()){
+				Instruction * useInstr = cast<Instruction>(user);
+				BasicBlock * useBlock = useInstr->getParent();
+				if(PHINode * phi = dyn_cast<PHINode>(useInstr)){
+					for(unsigned i = 0; i < phi->getNumIncomingValues(); ++i){
+						BasicBlock * pred = phi->getIncomingBlock(i);
+						if(phi->getIncomingValue(i) == def &&
+							std::find(pred_begin(useBlock), pred_end(useBlock), pred) != pred_end(useBlock)){
+							markLiveOut(pred, idx);
+						}
+					}
+				}
+				else if(!(isKilledIn(useBlock, idx) && idx < InstrToIndex[useInstr])){
+					markLiveIn(useBlock, idx);
+				}
+			}
+		}
+	}
+
+	/*
+	 * The sparse analysis keeps no information per edge that could be reused, so
+	 * an update is a new run.
+	 */
+	void updateWorklistAlgorithm(Function * func) {
+		runWorklistAlgorithm(func);
+	}
+
+	/*
+	 * Call fn(src, dst, info) for every edge, in the order of DataFlowAnalysis::forEachEdge.
+	 * The information of the edges leaving a block is built when fn gets to them.
+	 */
+	template <typename Fn>
+	void forEachEdge(Fn fn) {
+		unsigned edgeId = 0;
+		for(; edgeId < Edges.size() && Edges[edgeId].first == 0; ++edgeId)
+			fn(Edges[edgeId].first, Edges[edgeId].second, EdgeInfos[edgeId]);
+		for(BasicBlock * block : Blocks){
+			std::vector<LivenessInfo> below;
+			unsigned first = computeBlock(block, below);
+			unsigned last = first + below.size() - 1;
+			for(; edgeId < SuccOffsets[last + 1]; ++edgeId){
+				LivenessInfo info(below[Edges[edgeId].first - first]);
+				addEdgeSpecificUses(Edges[edgeId], info);
+				fn(Edges[edgeId].first, Edges[edgeId].second, &info);
+			}
+		}
+	}
+
+	/*
+	 * Print the information of every edge, like DataFlowAnalysis::print().
+	 */
+	void print() {
+		forEachEdge([](unsigned src, unsigned dst, LivenessInfo * info) {
+			errs() << "Edge " << src << "->" "Edge " << dst << ":";
+			info->print();
+		});
+	}
+
+	/*
+	 * Build the information of the edge src -> dst into result.
+	 */
+	void getEdgeInfo(unsigned src, unsigned dst, LivenessInfo & result) {
+		unsigned edgeId = getEdgeId(src, dst);
+		if(src == 0){
+			result = *EdgeInfos[edgeId];
+			return;
+		}
+		std::vector<LivenessInfo> below;
+		unsigned first = computeBlock(IndexToInstr[src]->getParent(), below);
+		result = below[src - first];
+		addEdgeSpecificUses(Edges[edgeId], result);
+	}
+
+	bool isLiveIn(Instruction * I, BasicBlock * block) {
+		std::vector<unsigned> & in = LiveIn[BlockNumber[block]];
+		return std::binary_search(in.begin(), in.end(), InstrToIndex[I]);
+	}
+
+	bool isLiveOut(Instruction * I, BasicBlock * block) {
+		std::vector<unsigned> & out = LiveOut[BlockNumber[block]];
+		return std::binary_search(out.begin(), out.end(), InstrToIndex[I]);
+	}
+
+private:
+	std::vector<BasicBlock *> Blocks;
+	DenseMap<BasicBlock *, unsigned> BlockNumber;
+	// Sorted indices of the values live at the top (below the phi nodes) and at the
+	// bottom of each block
+	std::vector<std::vector<unsigned>> LiveIn;
+	std::vector<std::vector<unsigned>> LiveOut;
+
+	// True if the definition of the value at idx is in block and kills it
+	bool isKilledIn(BasicBlock * block, unsigned idx) {
+		Instruction * def = IndexToInstr[idx];
+		return def->getParent() == block && (isDefiningInstr(def) || isa<PHINode>(def));
+	}
+
+	static bool addLast(std::vector<unsigned> & list, unsigned idx) {
+		if(!list.empty() && list.back() == idx)
+			return false;
+		list.push_back(idx);
+		return true;
+	}
+
+	void markLiveOut(BasicBlock * block, unsigned idx) {
+		if(addLast(LiveOut[BlockNumber[block]], idx) && !isKilledIn(block, idx))
+			markLiveIn(block, idx);
+	}
+
+	void markLiveIn(BasicBlock * block, unsigned idx) {
+		std::vector<BasicBlock *> worklist(1, block);
+		while(!worklist.empty()){
+			BasicBlock * current = worklist.back();
+			worklist.pop_back();
+			if(!addLast(LiveIn[BlockNumber[current]], idx))
+				continue;
+			for(BasicBlock * pred : predecessors(current)){
+				if(addLast(LiveOut[BlockNumber[pred]], idx) && !isKilledIn(pred, idx))
+					worklist.push_back(pred);
+			}
+		}
+	}
+
+	/*
+	 * Replay the flow function over block, starting from its live-out set.
+	 * below[i] receives the information leaving the instruction with index first + i,
+	 * where first, the index of the first instruction of block, is returned.
+	 * For a leading phi node this is before the values of a particular predecessor are added.
+	 */
+	unsigned computeBlock(BasicBlock * block, std::vector<LivenessInfo> & below) {
+		unsigned first = InstrToIndex[&block->front()];
+		unsigned last = InstrToIndex[&block->back()];
+		below.resize(last - first + 1);
+
+		LivenessInfo current;
+		for(unsigned idx : LiveOut[BlockNumber[block]])
+			current.insert(idx);
+		for(unsigned idx = last; ; --idx){
+			Instruction * I = IndexToInstr[idx];
+			if(!isa<PHINode>(I)){
+				transfer(I, &current);
+				below[idx - first] = current;
+			}
+			else if(idx == first){
+				removePhis(I, &current);
+				below[0] = current;
+			}
+			if(idx == first)
+				break;
+		}
+		return first;
+	}
+
+	void addEdgeSpecificUses(const Edge & edge, LivenessInfo & info) {
+		Instruction * src = IndexToInstr[edge.first];
+		if(isa<PHINode>(src))
+			addPhiUses(src, IndexToInstr[edge.second]->getParent(), &info);
+	}
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_LIVENESSANALYSIS_H
@@ -0,0 +1,282 @@
+//===- MayPointToAnalysis.h - May-point-to analysis for CSE 231 DFA ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the lattice and the flow function of the may-point-to
+// analysis. The points-to sets of the lattice are hash-consed (see
+// PointsToSet.h).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_MAYPOINTTOANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_MAYPOINTTOANALYSIS_H
+
+#include "231DFA.h"
+#include "DFAResult.h"
+#include "PointsToSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * The may-point-to information at a program point: a map from the pointers held
+ * in registers to the allocas they may point to, and a map from each alloca to
+ * the allocas whose address may be stored in it.
+ *
+ * Both maps are hash-consed in the PointsToContext of the analysis, so copying
+ * an element copies two pointers and equal elements have equal pointers. An
+ * empty element has no context; it picks one up from the first non-empty
+ * element joined into it.
+ */
+class MayPointToInfo : public Info {
+public:
+	MayPointToInfo() : Context(nullptr), Registers(nullptr), Memory(nullptr) {}
+	MayPointToInfo(const MayPointToInfo& other) :
+		Info(other), Context(other.Context), Registers(other.Registers), Memory(other.Memory) {}
+	MayPointToInfo(PointsToContext &context, const PointsToMap * registers, const PointsToMap * memory) :
+		Context(&context), Registers(registers), Memory(memory) {}
+
+	MayPointToInfo& operator=(const MayPointToInfo& other) {
+		Context = other.Context;
+		Registers = other.Registers;
+		Memory = other.Memory;
+		return *this;
+	}
+
+	void print() {
+		printMap(Registers, "R");
+		printMap(Memory, "M");
+		errs() << "\n";
+	}
+
+	static void printMap(const PointsToMap * map, const char * prefix) {
+		if (!map)
+			return;
+		for (const PointsToMap::Entry &entry : map->entries()) {
+			errs() << prefix << entry.first << "->" << "(";
+			for (unsigned pointee : entry.second->elements())
+				errs() << "M" << pointee << "/";
+			errs() << ")" << "|";
+		}
+	}
+
+	void remap(const DFAIndexRemapping &mapping) {
+		if (!Context)
+			return;
+		Registers = remapMap(*Context, Registers, mapping);
+		Memory = remapMap(*Context, Memory, mapping);
+	}
+
+	static const PointsToMap * remapMap(PointsToContext &context, const PointsToMap * map,
+	                                    const DFAIndexRemapping &mapping) {
+		if (!map)
+			return nullptr;
+		const PointsToMap * remapped = nullptr;
+		for (const PointsToMap::Entry &entry : map->entries()) {
+			unsigned pointer = mapping.lookup(entry.first);
+			if (pointer == DFADeletedIndex)
+				continue;
+			SmallVector<unsigned, 16> pointees;
+			for (unsigned pointee : entry.second->elements()) {
+				if (mapping.lookup(pointee) != DFADeletedIndex)
+					pointees.push_back(mapping.lookup(pointee));
+			}
+			std::sort(pointees.begin(), pointees.end());
+			remapped = context.insert(remapped, pointer, context.getSet(pointees));
+		}
+		return remapped;
+	}
+
+	static const DFAResultKind ResultKind = DFAResultKind::PointsTo;
+
+	/*
+	 * Append the register map then the memory map to words, each as its size
+	 * followed by (pointer, number of pointees, pointees...) per entry.
+	 */
+	void encode(std::vector<uint32_t> &words) const {
+		encodeMap(Registers, words);
+		encodeMap(Memory, words);
+	}
+
+	static void encodeMap(const PointsToMap * map, std::vector<uint32_t> &words) {
+		words.push_back(map ? map->size() : 0);
+		if (!map)
+			return;
+		for (const PointsToMap::Entry &entry : map->entries()) {
+			words.push_back(entry.first);
+			words.push_back(entry.second->size());
+			words.insert(words.end(), entry.second->elements().begin(), entry.second->elements().end());
+		}
+	}
+
+	/*
+	 * Both elements must belong to the same analysis, whose context makes equal
+	 * maps identical.
+	 */
+	static bool equals(Info * info1, Info * info2) {
+		MayPointToInfo * a = (MayPointToInfo *)info1;
+		MayPointToInfo * b = (MayPointToInfo *)info2;
+		return a->Registers == b->Registers && a->Memory == b->Memory;
+	}
+
+	static bool joinInto(Info * dst, Info * src) {
+		MayPointToInfo * a = (MayPointToInfo *)dst;
+		MayPointToInfo * b = (MayPointToInfo *)src;
+		if (!a->Context)
+			a->Context = b->Context;
+		if (!a->Context)
+			return false;
+		const PointsToMap * registers = a->Context->join(a->Registers, b->Registers);
+		const PointsToMap * memory = a->Context->join(a->Memory, b->Memory);
+		bool changed = registers != a->Registers || memory != a->Memory;
+		a->Registers = registers;
+		a->Memory = memory;
+		return changed;
+	}
+
+	/*
+	 * The allocas the register defined by instruction pointer may point to, or
+	 * nullptr if there are none.
+	 */
+	const PointsToSet * getPointees(unsigned pointer) const {
+		return Registers ? Registers->lookup(pointer) : nullptr;
+	}
+
+	/*
+	 * The allocas whose address may be stored in the alloca mem_pointer, or
+	 * nullptr if there are none.
+	 */
+	const PointsToSet * getMemPointees(unsigned mem_pointer) const {
+		return Memory ? Memory->lookup(mem_pointer) : nullptr;
+	}
+
+	const PointsToMap * getRegisters() const {
+		return Registers;
+	}
+
+	const PointsToMap * getMemory() const {
+		return Memory;
+	}
+
+	void insert(PointsToContext &context, unsigned pointer, const PointsToSet * pointees){
+		Context = &context;
+		Registers = context.insert(Registers, pointer, pointees);
+	}
+
+	void insertStore(PointsToContext &context, unsigned mem_pointer, const PointsToSet * mem_pointees){
+		Context = &context;
+		Memory = context.insert(Memory, mem_pointer, mem_pointees);
+	}
+
+private:
+	PointsToContext * Context;
+	const PointsToMap * Registers;
+	const PointsToMap * Memory;
+};
+
+template <class Info, bool Direction>
+class MayPointToAnalysis : public DataFlowAnalysis<Info, Direction> {
+public:
+	MayPointToAnalysis(MayPointToInfo &bottom, MayPointToInfo &initialState) :
+		DataFlowAnalysis<Info, Direction>::DataFlowAnalysis(bottom, initialState){}
+
+	void flowfunction(Instruction * I,
+    									std::vector<unsigned> & IncomingEdges,
+										std::vector<unsigned> & OutgoingEdges,
+										std::vector<Info *> & Infos) {
+
+		unsigned idx = this->InstrToIndex[I];
+		Info *combineInfo = this->joinIncoming(idx);
+
+		Instruction *Rv = nullptr;
+		Instruction *Rp;
+		Instruction *R1;
+		Instruction *R2;
+
+		switch(I->getOpcode()){
+		case Instruction::Alloca:
+			combineInfo->insert(Context, idx, Context.getSingleton(idx));
+			break;
+
+		case Instruction::BitCast:
+			Rv = (Instruction*)(((CastInst*)I)->getOperand(0));
+			combineInfo->insert(Context, idx, getPointees(combineInfo, Rv));
+			break;
+
+		case Instruction::GetElementPtr:
+			Rv = (Instruction*)(((GetElementPtrInst*)I)->getPointerOperand());
+			combineInfo->insert(Context, idx, getPointees(combineInfo, Rv));
+			break;
+
+		case Instruction::Load:
+			Rp = (Instruction*)(((LoadInst*)I)->getPointerOperand());
+			if(const PointsToSet * pointee_set1 = getPointees(combineInfo, Rp)){
+				for(unsigned X : pointee_set1->elements())
+					combineInfo->insert(Context, idx, combineInfo->getMemPointees(X));
+			}
+			break;
+
+		case Instruction::Store:
+			Rv = (Instruction*)(((StoreInst*)I)->getValueOperand());
+			Rp = (Instruction*)(((StoreInst*)I)->getPointerOperand());
+			{
+				const PointsToSet * pointee_set1 = getPointees(combineInfo, Rv);
+				const PointsToSet * pointee_set2 = getPointees(combineInfo, Rp);
+				if(pointee_set1 && pointee_set2){
+					for(unsigned Y : pointee_set2->elements())
+						combineInfo->insertStore(Context, Y, pointee_set1);
+				}
+			}
+			break;
+
+		case Instruction::Select:
+			R1 = (Instruction*)(((SelectInst*)I)->getTrueValue());
+			R2 = (Instruction*)(((SelectInst*)I)->getFalseValue());
+			combineInfo->insert(Context, idx, getPointees(combineInfo, R1));
+			combineInfo->insert(Context, idx, getPointees(combineInfo, R2));
+			break;
+
+		case Instruction::PHI:
+			while(isa<PHINode>(I)){
+				PHINode* phi_inst = (PHINode*) I;
+				for(unsigned i = 0; i<phi_inst->getNumIncomingValues(); i++){
+					Rv = (Instruction*)(phi_inst->getIncomingValue(i));
+					combineInfo->insert(Context, idx, getPointees(combineInfo, Rv));
+				}
+				I = I->getNextNode();
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		this->shareOutgoingInfo(combineInfo, OutgoingEdges.size(), Infos);
+	}
+
+private:
+	// Owner of the points-to sets and maps of every Info of this analysis
+	PointsToContext Context;
+
+	/*
+	 * The allocas the register of V may point to according to info, or nullptr
+	 * if V is not an instruction of the function or points to nothing.
+	 */
+	const PointsToSet * getPointees(Info * info, Instruction * V) {
+		auto it = this->InstrToIndex.find(V);
+		if (it == this->InstrToIndex.end())
+			return nullptr;
+		return info->getPointees(it->second);
+	}
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_MAYPOINTTOANALYSIS_H
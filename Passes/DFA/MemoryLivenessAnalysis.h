@@ -0,0 +1,200 @@
+//===- MemoryLivenessAnalysis.h - Memory liveness analysis for CSE 231 DFA -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the lattice and the flow function of a backward analysis
+// of the allocas whose content may still be read, which tells the stores that
+// no later instruction reads.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_MEMORYLIVENESSANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_MEMORYLIVENESSANALYSIS_H
+
+#include "231DFA.h"
+#include "DFAAliasAnalysis.h"
+#include "IndexSetInfo.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include <vector>
+
+namespace llvm {
+
+class MemoryLivenessInfo : public IndexSetInfo<MemoryLivenessInfo> {
+public:
+	MemoryLivenessInfo() {}
+	MemoryLivenessInfo(unsigned index) : IndexSetInfo<MemoryLivenessInfo>(index) {}
+	MemoryLivenessInfo(const MemoryLivenessInfo& other) : IndexSetInfo<MemoryLivenessInfo>(other) {}
+};
+
+/*
+ * The information below an instruction holds the index of every alloca that
+ * some path from there may read before overwriting all of it. Nothing is live
+ * when the function returns, since its allocas go away with it.
+ *
+ * Pointers are resolved with an EscapePointsTo solved on the same function. A
+ * pointer to Unknown may read every escaped alloca, and so may any call. The
+ * solver may have been run before instructions were deleted: its sets still
+ * cover the pointers that remain.
+ */
+template <class Info, bool Direction>
+class MemoryLivenessAnalysis : public DataFlowAnalysis<Info, Direction> {
+public:
+	MemoryLivenessAnalysis(MemoryLivenessInfo &bottom, MemoryLivenessInfo &initialState, EscapePointsTo &pointsTo) :
+		DataFlowAnalysis<Info, Direction>::DataFlowAnalysis(bottom, initialState), PointsTo(pointsTo) {}
+
+	/*
+	 * The effect of I on the set of allocas live below it.
+	 */
+	void transfer(Instruction * I, Info * info) {
+		switch(I->getOpcode()){
+		case Instruction::Load:
+			addPointees(cast<LoadInst>(I)->getPointerOperand(), info);
+			break;
+		case Instruction::Store:
+			if(AllocaInst * alloca = getOverwrittenAlloca(cast<StoreInst>(I)))
+				info->remove(this->InstrToIndex[alloca]);
+			break;
+		case Instruction::AtomicCmpXchg:
+			addPointees(cast<AtomicCmpXchgInst>(I)->getPointerOperand(), info);
+			break;
+		case Instruction::AtomicRMW:
+			addPointees(cast<AtomicRMWInst>(I)->getPointerOperand(), info);
+			break;
+		case Instruction::Call:
+			addCallReads(cast<CallInst>(I), info);
+			break;
+		case Instruction::Invoke:
+			addCallReads(cast<InvokeInst>(I), info);
+			break;
+		default:
+			if(I->mayReadFromMemory())
+				addAllocas(info, false);
+			break;
+		}
+	}
+
+	void flowfunction(Instruction * I,
+    									std::vector<unsigned> & IncomingEdges,
+										std::vector<unsigned> & OutgoingEdges,
+										std::vector<Info *> & Infos) {
+
+		unsigned idx = this->InstrToIndex[I];
+		Info *combineInfo = this->joinIncoming(idx);
+		if(!isa<PHINode>(I))
+			transfer(I, combineInfo);
+		this->shareOutgoingInfo(combineInfo, OutgoingEdges.size(), Infos);
+	}
+
+	/*
+	 * Whether store only writes to allocas that no path from it reads again.
+	 */
+	bool isDeadStore(StoreInst * store) {
+		if(!store->isSimple())
+			return false;
+		SmallVector<unsigned, 4> objects;
+		bool unknown;
+		if(!PointsTo.getObjects(store->getPointerOperand(), objects, unknown) || unknown || objects.empty())
+			return false;
+		for(unsigned object : objects){
+			unsigned index = this->getIndexOf(PointsTo.getInstrOf(object));
+			if(index == 0)
+				return false;
+			bool live = this->anyIncomingInfo(store, [&](const Info &info) {
+				return info.getInfo().contains(index);
+			});
+			if(live)
+				return false;
+		}
+		return true;
+	}
+
+private:
+	EscapePointsTo &PointsTo;
+
+	/*
+	 * The alloca store writes entirely, if any. Only a store to the start of a
+	 * single alloca of at most its size counts.
+	 */
+	AllocaInst * getOverwrittenAlloca(StoreInst * store) {
+		AllocaInst * alloca = dyn_cast<AllocaInst>(store->getPointerOperand()->stripPointerCasts());
+		if(!alloca || alloca->isArrayAllocation() || this->getIndexOf(alloca) == 0)
+			return nullptr;
+		const DataLayout &DL = store->getModule()->getDataLayout();
+		if(DL.getTypeStoreSize(store->getValueOperand()->getType()) < DL.getTypeAllocSize(alloca->getAllocatedType()))
+			return nullptr;
+		return alloca;
+	}
+
+	/*
+	 * Add the allocas pointer may point to.
+	 */
+	void addPointees(Value * pointer, Info * info) {
+		SmallVector<unsigned, 4> objects;
+		bool unknown;
+		if(!PointsTo.getObjects(pointer, objects, unknown)){
+			addAllocas(info, false);
+			return;
+		}
+		for(unsigned object : objects){
+			if(unsigned index = this->getIndexOf(PointsTo.getInstrOf(object)))
+				info->insert(index);
+		}
+		if(unknown)
+			addAllocas(info, true);
+	}
+
+	/*
+	 * Add every alloca of the function, or only the escaped ones.
+	 */
+	void addAllocas(Info * info, bool escapedOnly) {
+		for(auto &entry : this->IndexToInstr){
+			if(!entry.second || !isa<AllocaInst>(entry.second))
+				continue;
+			if(escapedOnly){
+				unsigned object = PointsTo.getIndexOf(entry.second);
+				if(object == 0 || !PointsTo.isEscaped(object))
+					continue;
+			}
+			info->insert(entry.first);
+		}
+	}
+
+	/*
+	 * A call may read the escaped allocas and the ones its arguments point to,
+	 * except for the intrinsics that read nothing or only their source.
+	 */
+	template <class CallT>
+	void addCallReads(CallT * call, Info * info) {
+		if(IntrinsicInst * intrinsic = dyn_cast<IntrinsicInst>(call)){
+			switch(intrinsic->getIntrinsicID()){
+			case Intrinsic::lifetime_start:
+			case Intrinsic::lifetime_end:
+			case Intrinsic::dbg_declare:
+			case Intrinsic::dbg_value:
+			case Intrinsic::memset:
+				return;
+			case Intrinsic::memcpy:
+			case Intrinsic::memmove:
+				addPointees(cast<MemTransferInst>(intrinsic)->getRawSource(), info);
+				return;
+			default:
+				break;
+			}
+		}
+		addAllocas(info, true);
+		for(Value * argument : call->arg_operands())
+			addPointees(argument, info);
+	}
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_MEMORYLIVENESSANALYSIS_H
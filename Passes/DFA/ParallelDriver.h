@@ -0,0 +1,126 @@
+//===- ParallelDriver.h - Module-level driver for CSE 231 DFA ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides a driver that runs a dataflow analysis on every function
+// of a module on several threads and prints the results in function order, or
+// writes them to the file named by -cse231-dfa-output.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_PARALLELDRIVER_H
+#define LLVM_TRANSFORMS_231DFA_PARALLELDRIVER_H
+
+#include "231DFA.h"
+#include "DFAResult.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace llvm {
+
+// Number of worker threads of the module drivers, set by -cse231-dfa-threads.
+// 0 means one per hardware thread.
+extern cl::opt<unsigned> DFAThreads;
+
+// File the passes write their results to in the format of DFAResult.h instead
+// of printing them, set by -cse231-dfa-output. Empty means print.
+extern cl::opt<std::string> DFAOutputFile;
+
+/*
+ * Run AnalysisT on every function defined in M and print the results.
+ *
+ * Functions are handed out to the workers one at a time, biggest first, so a
+ * single huge function starts early instead of stalling the end of the run while
+ * the other threads keep taking the small ones. The calling thread prints each
+ * result as soon as it and all the functions before it are done, so the output is
+ * the same as running the function pass on each function in order.
+ */
+template <class AnalysisT, class InfoT>
+void runAnalysisOnModule(Module &M, InfoT &bottom, InfoT &initialState) {
+	std::vector<Function *> functions;
+	std::vector<unsigned> sizes;
+	for (Function &F : M) {
+		if (F.isDeclaration())
+			continue;
+		unsigned size = 0;
+		for (BasicBlock &BB : F)
+			size += BB.size();
+		functions.push_back(&F);
+		sizes.push_back(size);
+	}
+	if (functions.empty())
+		return;
+
+	std::vector<unsigned> schedule(functions.size());
+	std::iota(schedule.begin(), schedule.end(), 0);
+	std::stable_sort(schedule.begin(), schedule.end(),
+	                 [&](unsigned a, unsigned b) { return sizes[a] > sizes[b]; });
+
+	std::vector<std::unique_ptr<AnalysisT>> results(functions.size());
+	std::vector<bool> done(functions.size(), false);
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::atomic<unsigned> next(0);
+
+	auto worker = [&]() {
+		for (unsigned pos = next++; pos < schedule.size(); pos = next++) {
+			unsigned i = schedule[pos];
+			std::unique_ptr<AnalysisT> analysis(new AnalysisT(bottom, initialState));
+			analysis->runWorklistAlgorithm(functions[i]);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				results[i] = std::move(analysis);
+				done[i] = true;
+			}
+			finished.notify_all();
+		}
+	};
+
+	unsigned numThreads = DFAThreads;
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	numThreads = std::min<unsigned>(numThreads, functions.size());
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < numThreads; ++t)
+		threads.emplace_back(worker);
+
+	DFAResultWriter writer;
+	for (unsigned i = 0; i < functions.size(); ++i) {
+		std::unique_ptr<AnalysisT> analysis;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [&]() { return done[i]; });
+			analysis = std::move(results[i]);
+		}
+		if (DFAOutputFile.empty())
+			analysis->print();
+		else
+			writer.addFunction(functions[i]->getName(), *analysis);
+		if (DFAPrintStatistics)
+			analysis->printStatistics();
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	if (!DFAOutputFile.empty())
+		writer.write(DFAOutputFile);
+}
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_PARALLELDRIVER_H
@@ -0,0 +1,245 @@
+//===- PointsToSet.h - Hash-consed points-to sets for CSE 231 DFA --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides immutable points-to sets and points-to maps that are
+// hash-consed by a PointsToContext: equal sets (maps) are the same object, so
+// they are stored once, compared by pointer, and shared by every lattice
+// element that holds them. Joins are memoized and return one of their operands
+// whenever it already contains the other.
+//
+// The empty set and the empty map are represented by nullptr, so an empty
+// lattice element needs no context.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_POINTSTOSET_H
+#define LLVM_TRANSFORMS_231DFA_POINTSTOSET_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace llvm {
+
+/*
+ * A sorted set of instruction indices.
+ */
+class PointsToSet : public FoldingSetNode {
+  public:
+    ArrayRef<unsigned> elements() const {
+    	return makeArrayRef(Elements, Size);
+    }
+
+    unsigned size() const {
+    	return Size;
+    }
+
+    bool contains(unsigned idx) const {
+    	return std::binary_search(Elements, Elements + Size, idx);
+    }
+
+    void Profile(FoldingSetNodeID &ID) const {
+    	profile(ID, elements());
+    }
+
+    static void profile(FoldingSetNodeID &ID, ArrayRef<unsigned> elements) {
+    	for (unsigned idx : elements)
+    		ID.AddInteger(idx);
+    }
+
+  private:
+    friend class PointsToContext;
+
+    PointsToSet(const unsigned * elements, unsigned size) : Elements(elements), Size(size) {}
+
+    const unsigned * Elements;
+    unsigned Size;
+};
+
+/*
+ * A map from an instruction index to a non-empty PointsToSet, sorted by key.
+ */
+class PointsToMap : public FoldingSetNode {
+  public:
+    typedef std::pair<unsigned, const PointsToSet *> Entry;
+
+    ArrayRef<Entry> entries() const {
+    	return makeArrayRef(Entries, Size);
+    }
+
+    unsigned size() const {
+    	return Size;
+    }
+
+    /*
+     * The set of key, or nullptr if key has none.
+     */
+    const PointsToSet * lookup(unsigned key) const {
+    	const Entry * it = std::lower_bound(Entries, Entries + Size, key,
+    		[](const Entry &entry, unsigned key) { return entry.first < key; });
+    	return it != Entries + Size && it->first == key ? it->second : nullptr;
+    }
+
+    void Profile(FoldingSetNodeID &ID) const {
+    	profile(ID, entries());
+    }
+
+    static void profile(FoldingSetNodeID &ID, ArrayRef<Entry> entries) {
+    	for (const Entry &entry : entries) {
+    		ID.AddInteger(entry.first);
+    		ID.AddPointer(entry.second);
+    	}
+    }
+
+  private:
+    friend class PointsToContext;
+
+    PointsToMap(const Entry * entries, unsigned size) : Entries(entries), Size(size) {}
+
+    const Entry * Entries;
+    unsigned Size;
+};
+
+/*
+ * Owner of the sets and maps built while analyzing one function. Everything
+ * is freed at once when the context dies, so the lattice elements holding
+ * them must not outlive it.
+ */
+class PointsToContext {
+  public:
+    PointsToContext() {}
+    PointsToContext(const PointsToContext &) = delete;
+    PointsToContext &operator=(const PointsToContext &) = delete;
+
+    /*
+     * The set of the sorted, duplicate-free elements, or nullptr if there are none.
+     */
+    const PointsToSet * getSet(ArrayRef<unsigned> elements) {
+    	if (elements.empty())
+    		return nullptr;
+    	FoldingSetNodeID ID;
+    	PointsToSet::profile(ID, elements);
+    	void * insertPos;
+    	if (PointsToSet * set = Sets.FindNodeOrInsertPos(ID, insertPos))
+    		return set;
+    	unsigned * data = Allocator.Allocate<unsigned>(elements.size());
+    	std::copy(elements.begin(), elements.end(), data);
+    	PointsToSet * set = new (Allocator.Allocate<PointsToSet>()) PointsToSet(data, elements.size());
+    	Sets.InsertNode(set, insertPos);
+    	return set;
+    }
+
+    /*
+     * The map of the entries sorted by key, or nullptr if there are none.
+     */
+    const PointsToMap * getMap(ArrayRef<PointsToMap::Entry> entries) {
+    	if (entries.empty())
+    		return nullptr;
+    	FoldingSetNodeID ID;
+    	PointsToMap::profile(ID, entries);
+    	void * insertPos;
+    	if (PointsToMap * map = Maps.FindNodeOrInsertPos(ID, insertPos))
+    		return map;
+    	PointsToMap::Entry * data = Allocator.Allocate<PointsToMap::Entry>(entries.size());
+    	std::uninitialized_copy(entries.begin(), entries.end(), data);
+    	PointsToMap * map = new (Allocator.Allocate<PointsToMap>()) PointsToMap(data, entries.size());
+    	Maps.InsertNode(map, insertPos);
+    	return map;
+    }
+
+    const PointsToSet * getSingleton(unsigned idx) {
+    	return getSet(makeArrayRef(idx));
+    }
+
+    /*
+     * Union of two sets. Returns a when b is a subset of it, and b when a is.
+     */
+    const PointsToSet * join(const PointsToSet * a, const PointsToSet * b) {
+    	if (a == b || !b)
+    		return a;
+    	if (!a)
+    		return b;
+    	std::pair<const PointsToSet *, const PointsToSet *> key = std::minmax(a, b);
+    	auto it = SetJoins.find(key);
+    	if (it != SetJoins.end())
+    		return it->second;
+
+    	SmallVector<unsigned, 16> elements;
+    	std::set_union(a->Elements, a->Elements + a->Size, b->Elements, b->Elements + b->Size,
+    	               std::back_inserter(elements));
+    	const PointsToSet * result = elements.size() == a->Size ? a
+    	                           : elements.size() == b->Size ? b : getSet(elements);
+    	SetJoins[key] = result;
+    	return result;
+    }
+
+    /*
+     * Pointwise union of two maps. Returns a when b is below it, and b when a is.
+     */
+    const PointsToMap * join(const PointsToMap * a, const PointsToMap * b) {
+    	if (a == b || !b)
+    		return a;
+    	if (!a)
+    		return b;
+    	std::pair<const PointsToMap *, const PointsToMap *> key = std::minmax(a, b);
+    	auto it = MapJoins.find(key);
+    	if (it != MapJoins.end())
+    		return it->second;
+
+    	SmallVector<PointsToMap::Entry, 16> entries;
+    	bool sameAsA = true, sameAsB = true;
+    	const PointsToMap::Entry * ia = a->Entries, * ea = a->Entries + a->Size;
+    	const PointsToMap::Entry * ib = b->Entries, * eb = b->Entries + b->Size;
+    	while (ia != ea || ib != eb) {
+    		if (ib == eb || (ia != ea && ia->first < ib->first)) {
+    			entries.push_back(*ia++);
+    			sameAsB = false;
+    		} else if (ia == ea || ib->first < ia->first) {
+    			entries.push_back(*ib++);
+    			sameAsA = false;
+    		} else {
+    			const PointsToSet * set = join(ia->second, ib->second);
+    			sameAsA = sameAsA && set == ia->second;
+    			sameAsB = sameAsB && set == ib->second;
+    			entries.push_back(std::make_pair(ia->first, set));
+    			++ia;
+    			++ib;
+    		}
+    	}
+    	const PointsToMap * result = sameAsA ? a : sameAsB ? b : getMap(entries);
+    	MapJoins[key] = result;
+    	return result;
+    }
+
+    /*
+     * map with the set of key joined with pointees.
+     */
+    const PointsToMap * insert(const PointsToMap * map, unsigned key, const PointsToSet * pointees) {
+    	if (!pointees)
+    		return map;
+    	PointsToMap::Entry entry = std::make_pair(key, pointees);
+    	return join(map, getMap(makeArrayRef(entry)));
+    }
+
+  private:
+    BumpPtrAllocator Allocator;
+    FoldingSet<PointsToSet> Sets;
+    FoldingSet<PointsToMap> Maps;
+    DenseMap<std::pair<const PointsToSet *, const PointsToSet *>, const PointsToSet *> SetJoins;
+    DenseMap<std::pair<const PointsToMap *, const PointsToMap *>, const PointsToMap *> MapJoins;
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_POINTSTOSET_H
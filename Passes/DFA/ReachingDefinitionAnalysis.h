@@ -0,0 +1,58 @@
+//===- ReachingDefinitionAnalysis.h - Reaching definition analysis for CSE 231 DFA ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the lattice and the flow function of the reaching
+// definition analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231DFA_REACHINGDEFINITIONANALYSIS_H
+#define LLVM_TRANSFORMS_231DFA_REACHINGDEFINITIONANALYSIS_H
+
+#include "231DFA.h"
+#include "IndexSetInfo.h"
+#include <vector>
+
+namespace llvm {
+
+class ReachingInfo : public IndexSetInfo<ReachingInfo> {
+public:
+	ReachingInfo() {}
+	ReachingInfo(unsigned index) : IndexSetInfo<ReachingInfo>(index) {}
+	ReachingInfo(ReachingInfo& other) : IndexSetInfo<ReachingInfo>(other) {}
+};
+
+template <class Info, bool Direction>
+class ReachingDefinitionAnalysis : public DataFlowAnalysis<Info, Direction> {
+public:
+	ReachingDefinitionAnalysis(ReachingInfo &bottom, ReachingInfo &initialState) : 
+		DataFlowAnalysis<Info, Direction>::DataFlowAnalysis(bottom, initialState){}
+
+	void flowfunction(Instruction * I,
+    									std::vector<unsigned> & IncomingEdges,
+										std::vector<unsigned> & OutgoingEdges,
+										std::vector<Info *> & Infos) {
+
+		unsigned idx = this->InstrToIndex[I];
+		Info *combineInfo = this->joinIncoming(idx);
+		if(isDefiningInstr(I)){
+			combineInfo->insert(idx);
+		}
+		else if(isa<PHINode>(I)){
+			while(isa<PHINode>(I)){
+				combineInfo->insert(this->InstrToIndex[I]);
+				I = I->getNextNode();
+			}
+		}
+		this->shareOutgoingInfo(combineInfo, OutgoingEdges.size(), Infos);
+	}
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231DFA_REACHINGDEFINITIONANALYSIS_H
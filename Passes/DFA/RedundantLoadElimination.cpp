@@ -0,0 +1,79 @@
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "231DFA.h"
+#include "AvailableMemoryAnalysis.h"
+#include "DFAAliasAnalysis.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+/*
+ * Replaces every load whose value is available in memory by that value: the
+ * value of the store before it is forwarded, or the result of the earlier load
+ * reused. What memory holds does not change, so one run of the analysis finds
+ * all of them.
+ */
+struct RedundantLoadEliminationPass : public FunctionPass {
+ 	static char ID;
+  	RedundantLoadEliminationPass() : FunctionPass(ID) {}
+
+  	bool runOnFunction(Function &F) override {
+  		EscapePointsTo pointsTo;
+  		pointsTo.analyze(&F);
+  		AvailableMemoryInfo bottom;
+  		AvailableMemoryAnalysis<AvailableMemoryInfo, true> available(bottom, bottom, pointsTo);
+  		available.runWorklistAlgorithm(&F);
+
+  		// Nothing reaches unreachable blocks, so everything looks available there
+  		SmallPtrSet<BasicBlock *, 32> reachable;
+  		for (BasicBlock * block : depth_first(&F.getEntryBlock()))
+  			reachable.insert(block);
+
+  		unsigned forwardedStores = 0;
+  		unsigned redundantLoads = 0;
+  		// Value each removed load was replaced with
+  		DenseMap<Value *, Value *> replaced;
+  		std::vector<Instruction *> dead;
+  		for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+  			LoadInst * load = dyn_cast<LoadInst>(&*I);
+  			if (!load || !reachable.count(load->getParent()))
+  				continue;
+  			Instruction * source = available.getAvailableOperation(load);
+  			if (!source)
+  				continue;
+  			Value * value = source;
+  			if (StoreInst * store = dyn_cast<StoreInst>(source)) {
+  				value = store->getValueOperand();
+  				++forwardedStores;
+  			} else {
+  				++redundantLoads;
+  			}
+  			for (auto it = replaced.find(value); it != replaced.end(); it = replaced.find(value))
+  				value = it->second;
+  			load->replaceAllUsesWith(value);
+  			replaced[load] = value;
+  			dead.push_back(load);
+  		}
+  		for (Instruction * I : dead)
+  			I->eraseFromParent();
+
+  		errs() << "Function " << F.getName() << ": forwarded " << forwardedStores << " stores and removed "
+  		       << redundantLoads << " redundant loads\n";
+  		if (DFAPrintStatistics)
+  			available.printStatistics();
+
+  		return !dead.empty();
+  	}
+}; // end of struct
+}  // end of anonymous namespace
+
+char RedundantLoadEliminationPass::ID = 0;
+static RegisterPass<RedundantLoadEliminationPass> X("cse231-rle", "store-to-load forwarding and redundant load elimination",
+                             false /* Only looks at CFG */,
+                             false /* Analysis Pass */);
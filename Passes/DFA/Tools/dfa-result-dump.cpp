@@ -0,0 +1,82 @@
+//===- dfa-result-dump.cpp - Print a CSE 231 DFA result file -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool maps a file written with -cse231-dfa-output and prints its content
+// in the text format of the analysis passes, either for every function or for
+// one function or edge.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DFAResult.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+
+using namespace llvm;
+
+static cl::opt<std::string> InputFilename(cl::Positional, cl::desc("<result file>"), cl::Required);
+
+static cl::opt<std::string> FunctionName("function", cl::desc("Only print the edges of this function"),
+                                         cl::value_desc("name"), cl::init(""));
+
+static cl::opt<int> EdgeSrc("src", cl::desc("With -function and -dst, only print the edge from this instruction"),
+                            cl::init(-1));
+
+static cl::opt<int> EdgeDst("dst", cl::desc("With -function and -src, only print the edge to this instruction"),
+                            cl::init(-1));
+
+static cl::opt<bool> ListFunctions("list", cl::desc("Print the functions and their number of edges"),
+                                   cl::init(false));
+
+int main(int argc, char **argv) {
+	cl::ParseCommandLineOptions(argc, argv, "CSE 231 dataflow result dumper\n");
+
+	ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(InputFilename);
+	if (std::error_code ec = buffer.getError()) {
+		errs() << argv[0] << ": " << InputFilename << ": " << ec.message() << "\n";
+		return 1;
+	}
+
+	DFAResultFile result;
+	if (!result.init((*buffer)->getBufferStart(), (*buffer)->getBufferSize())) {
+		errs() << argv[0] << ": " << InputFilename << ": not a valid dataflow result file\n";
+		return 1;
+	}
+
+	if (ListFunctions) {
+		for (unsigned f = 0; f < result.getNumFunctions(); ++f)
+			outs() << result.getFunctionName(f) << " " << result.getEdges(f).size() << "\n";
+		return 0;
+	}
+
+	if (FunctionName.empty()) {
+		for (unsigned f = 0; f < result.getNumFunctions(); ++f)
+			result.printFunction(outs(), f);
+		return 0;
+	}
+
+	int f = result.findFunction(FunctionName);
+	if (f < 0) {
+		errs() << argv[0] << ": no function " << FunctionName << " in " << InputFilename << "\n";
+		return 1;
+	}
+	if (EdgeSrc < 0 || EdgeDst < 0) {
+		result.printFunction(outs(), f);
+		return 0;
+	}
+
+	const DFAEdgeRecord * edge = result.findEdge(f, EdgeSrc, EdgeDst);
+	if (!edge) {
+		errs() << argv[0] << ": no edge " << EdgeSrc << "->" << EdgeDst << " in " << FunctionName << "\n";
+		return 1;
+	}
+	DFAResultFile::printPayload(outs(), result.getKind(), result.getPayload(*edge));
+	return 0;
+}
@@ -15,16 +15,356 @@
 #include "llvm/ADT/APInt.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include "Instrumentation.h"
+#include "BranchProfile.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 using namespace llvm;
 
+enum class BBMode { Bias, Inline, Sites };
+
+static cl::opt<BBMode> BranchBiasMode(
+	"cse231-bb-mode", cl::desc("What -cse231-bb records"),
+	cl::values(clEnumValN(BBMode::Bias, "bias", "pass the condition of every conditional branch to updateBranchInfo"),
+	           clEnumValN(BBMode::Inline, "inline", "add every condition to per-branch taken/total counters in the IR, report at exit"),
+	           clEnumValN(BBMode::Sites, "sites", "count each successor of each branch and switch, write a profile at exit")),
+	cl::init(BBMode::Bias));
+
+static cl::opt<unsigned> BranchSamplePeriod("cse231-bb-sample", cl::init(1),
+                                           cl::desc("In inline mode, only count one execution in N and scale the report by N"));
+
+static cl::opt<bool> BranchAtomic("cse231-bb-atomic", cl::init(false),
+                                  cl::desc("In inline mode, use atomic increments, for multithreaded programs"));
+
+static cl::opt<std::string> BranchProfileFile("cse231-bb-profile", cl::init("cse231.prof"),
+                                              cl::desc("Branch profile read by -cse231-bb-annotate"));
+
+/*
+ * The branch sites of F: its conditional branches and switches, in layout order.
+ * The id of a site is its position in this list. Together with the GUID of F it
+ * identifies the site in the profile, so the instrumentation and the annotation
+ * must see the same CFG.
+ */
+static void collectBranchSites(Function &F, std::vector<Instruction *> &sites) {
+	for (BasicBlock &BB : F) {
+		Instruction *term = BB.getTerminator();
+		BranchInst *bi = dyn_cast<BranchInst>(term);
+		if ((bi && bi->isConditional()) || isa<SwitchInst>(term))
+			sites.push_back(term);
+	}
+}
+
 namespace {
 struct BranchBias : public FunctionPass {
  	static char ID;
   	BranchBias() : FunctionPass(ID) {}
 
+  	// Sites mode: module constructor registering the counters of each function
+  	Function *RegisterFunction = nullptr;
+
+  	// Inline mode: the function reporting the counters at exit, the call to
+  	// printOutBranchInfo that ends it, the function adding up the counters of
+  	// one function, and the countdown to the next sampled execution
+  	Function *DumpFunction = nullptr;
+  	Instruction *DumpPrint = nullptr;
+  	Function *CollectFunction = nullptr;
+  	GlobalVariable *SampleCountdown = nullptr;
+
+  	bool doInitialization(Module &M) override {
+  		RegisterFunction = nullptr;
+  		DumpFunction = nullptr;
+  		DumpPrint = nullptr;
+  		CollectFunction = nullptr;
+  		SampleCountdown = nullptr;
+  		if (BranchBiasMode == BBMode::Inline) {
+  			createInlineRuntime(M);
+  			return true;
+  		}
+  		if (BranchBiasMode != BBMode::Sites)
+  			return false;
+
+  		LLVMContext &context = M.getContext();
+  		RegisterFunction = Function::Create(FunctionType::get(Type::getVoidTy(context), false),
+  		                                    GlobalValue::InternalLinkage, "bb.register", &M);
+  		IRBuilder<> Builder(BasicBlock::Create(context, "entry", RegisterFunction));
+  		Builder.CreateRetVoid();
+  		appendToGlobalCtors(M, RegisterFunction, 0);
+  		return true;
+  	}
+
+  	/*
+  	 * Inline mode: create bb.dump, run at exit, which reports the counters of every
+  	 * instrumented function and then calls printOutBranchInfo, and bb.collect:
+  	 *
+  	 *   void bb.collect(i64 *counters, i32 n)
+  	 *     taken = total = 0;
+  	 *     for (i = 0; i < n; ++i) { taken += counters[2*i]; total += counters[2*i+1]; }
+  	 *     addBranchInfo(taken * period, total * period);
+  	 *
+  	 * where period is -cse231-bb-sample. n must not be 0.
+  	 */
+  	void createInlineRuntime(Module &M) {
+  		LLVMContext &context = M.getContext();
+  		Type *int32Ty = Type::getInt32Ty(context);
+  		Type *int64Ty = Type::getInt64Ty(context);
+  		Type *int64PtrTy = Type::getInt64PtrTy(context);
+  		unsigned period = std::max(1u, (unsigned)BranchSamplePeriod);
+
+  		Constant *addBranchInfo = M.getOrInsertFunction(
+		    "addBranchInfo",               // name of function
+		    Type::getVoidTy(context),        // return type
+		    Type::getInt64Ty(context),		   // taken
+		    Type::getInt64Ty(context)		   // total
+		  );
+
+  		Constant *printOutBranchInfo = M.getOrInsertFunction(
+		    "printOutBranchInfo",               // name of function
+		    Type::getVoidTy(context)        // return type
+		  );
+
+  		CollectFunction = Function::Create(
+  			FunctionType::get(Type::getVoidTy(context), {int64PtrTy, int32Ty}, false),
+  			GlobalValue::InternalLinkage, "bb.collect", &M);
+  		Function::arg_iterator args = CollectFunction->arg_begin();
+  		Value *counters = &*args++;
+  		Value *n = &*args++;
+  		BasicBlock *entry = BasicBlock::Create(context, "entry", CollectFunction);
+  		BasicBlock *loop = BasicBlock::Create(context, "loop", CollectFunction);
+  		BasicBlock *exit = BasicBlock::Create(context, "exit", CollectFunction);
+
+  		IRBuilder<> Builder(entry);
+  		Builder.CreateBr(loop);
+
+  		Builder.SetInsertPoint(loop);
+  		PHINode *i = Builder.CreatePHI(int32Ty, 2, "i");
+  		PHINode *taken = Builder.CreatePHI(int64Ty, 2, "taken");
+  		PHINode *total = Builder.CreatePHI(int64Ty, 2, "total");
+  		i->addIncoming(Builder.getInt32(0), entry);
+  		taken->addIncoming(Builder.getInt64(0), entry);
+  		total->addIncoming(Builder.getInt64(0), entry);
+  		Value *base = Builder.CreateMul(i, Builder.getInt32(2));
+  		Value *siteTaken = Builder.CreateLoad(int64Ty, Builder.CreateInBoundsGEP(int64Ty, counters, base));
+  		Value *siteTotal = Builder.CreateLoad(int64Ty,
+  			Builder.CreateInBoundsGEP(int64Ty, counters, Builder.CreateAdd(base, Builder.getInt32(1))));
+  		Value *nextTaken = Builder.CreateAdd(taken, siteTaken);
+  		Value *nextTotal = Builder.CreateAdd(total, siteTotal);
+  		Value *next = Builder.CreateAdd(i, Builder.getInt32(1));
+  		i->addIncoming(next, loop);
+  		taken->addIncoming(nextTaken, loop);
+  		total->addIncoming(nextTotal, loop);
+  		Builder.CreateCondBr(Builder.CreateICmpEQ(next, n), exit, loop);
+
+  		Builder.SetInsertPoint(exit);
+  		std::vector<Value*> args1;
+  		args1.push_back(Builder.CreateMul(nextTaken, Builder.getInt64(period)));
+  		args1.push_back(Builder.CreateMul(nextTotal, Builder.getInt64(period)));
+  		Builder.CreateCall(addBranchInfo, args1);
+  		Builder.CreateRetVoid();
+
+  		DumpFunction = Function::Create(FunctionType::get(Type::getVoidTy(context), false),
+  		                                GlobalValue::InternalLinkage, "bb.dump", &M);
+  		Builder.SetInsertPoint(BasicBlock::Create(context, "entry", DumpFunction));
+  		DumpPrint = Builder.CreateCall(printOutBranchInfo);
+  		Builder.CreateRetVoid();
+  		appendToGlobalDtors(M, DumpFunction, 0);
+
+  		if (period > 1)
+  			SampleCountdown = new GlobalVariable(
+  				M,
+  				int32Ty,
+  				false,
+  				GlobalValue::InternalLinkage,
+  				Builder.getInt32(period),
+  				"bb.sample");
+  	}
+
+  	/*
+  	 * Add amount to the i64 counter, atomically if -cse231-bb-atomic is set.
+  	 */
+  	static void emitIncrement(IRBuilder<> &Builder, Value *counter, Value *amount) {
+  		if (BranchAtomic) {
+  			Builder.CreateAtomicRMW(AtomicRMWInst::Add, counter, amount, AtomicOrdering::Monotonic);
+  		}
+  		else {
+  			Value *count = Builder.CreateLoad(Builder.getInt64Ty(), counter);
+  			Builder.CreateStore(Builder.CreateAdd(count, amount), counter);
+  		}
+  	}
+
+  	/*
+  	 * Inline mode: give each conditional branch a taken and a total counter and
+  	 * update them without a call or a branch: taken += zext(condition), total += 1.
+  	 *
+  	 * With -cse231-bb-sample=N, a countdown shared by all branches of the module
+  	 * picks one execution in N. Only that one updates the counters, in a block
+  	 * split off the branch and marked unlikely. The countdown is not atomic, so
+  	 * threads may skip or repeat a sample; the totals stay estimates either way.
+  	 */
+  	bool instrumentInline(Function &F) {
+  		std::vector<BranchInst *> branches;
+  		for (BasicBlock &BB : F) {
+  			BranchInst *bi = dyn_cast<BranchInst>(BB.getTerminator());
+  			if (bi && bi->isConditional())
+  				branches.push_back(bi);
+  		}
+  		if (branches.empty())
+  			return false;
+
+  		Module *M = F.getParent();
+  		LLVMContext &context = F.getContext();
+  		ArrayType *countersTy = ArrayType::get(Type::getInt64Ty(context), 2 * branches.size());
+  		GlobalVariable *counters = new GlobalVariable(
+  			*M,
+  			countersTy,
+  			false,
+  			GlobalValue::InternalLinkage,
+  			ConstantAggregateZero::get(countersTy),
+  			"bb.bias");
+
+  		for (unsigned i = 0; i < branches.size(); ++i) {
+  			BranchInst *bi = branches[i];
+  			IRBuilder<> Builder(bi);
+  			if (SampleCountdown) {
+  				unsigned period = BranchSamplePeriod;
+  				Value *countdown = Builder.CreateSub(Builder.CreateLoad(Builder.getInt32Ty(), SampleCountdown),
+  				                                     Builder.getInt32(1));
+  				Value *sampled = Builder.CreateICmpEQ(countdown, Builder.getInt32(0));
+  				Builder.CreateStore(Builder.CreateSelect(sampled, Builder.getInt32(period), countdown),
+  				                    SampleCountdown);
+  				MDNode *weights = MDBuilder(context).createBranchWeights(1, period - 1);
+  				Builder.SetInsertPoint(SplitBlockAndInsertIfThen(sampled, bi, false, weights));
+  			}
+  			Value *taken = Builder.CreateConstInBoundsGEP2_32(countersTy, counters, 0, 2 * i);
+  			Value *total = Builder.CreateConstInBoundsGEP2_32(countersTy, counters, 0, 2 * i + 1);
+  			emitIncrement(Builder, taken, Builder.CreateZExt(bi->getCondition(), Builder.getInt64Ty()));
+  			emitIncrement(Builder, total, Builder.getInt64(1));
+  		}
+
+  		IRBuilder<> Builder(DumpPrint);
+  		std::vector<Value*> args1;
+  		args1.push_back(Builder.CreatePointerCast(counters, Type::getInt64PtrTy(context)));
+  		args1.push_back(Builder.getInt32(branches.size()));
+  		Builder.CreateCall(CollectFunction, args1);
+  		return true;
+  	}
+
+  	/*
+  	 * Add one to the i64 counter at index in counters.
+  	 */
+  	static void emitSiteIncrement(IRBuilder<> &Builder, ArrayType *countersTy, GlobalVariable *counters, Value *index) {
+  		Value *counter = Builder.CreateInBoundsGEP(countersTy, counters, {Builder.getInt32(0), index});
+  		Value *count = Builder.CreateLoad(Builder.getInt64Ty(), counter);
+  		Builder.CreateStore(Builder.CreateAdd(count, Builder.getInt64(1)), counter);
+  	}
+
+  	/*
+  	 * Count each successor of a switch on its own edge, so an execution costs one
+  	 * increment whatever the number of cases: in the successor when the edge is its
+  	 * only way in, otherwise in a block split off the edge. A switch with a single
+  	 * successor counts it before the switch.
+  	 */
+  	static void instrumentSwitch(SwitchInst *si, ArrayType *countersTy, GlobalVariable *counters, unsigned base) {
+  		if (si->getNumSuccessors() == 1) {
+  			IRBuilder<> Builder(si);
+  			emitSiteIncrement(Builder, countersTy, counters, Builder.getInt32(base));
+  			return;
+  		}
+  		for (unsigned k = 0; k < si->getNumSuccessors(); ++k) {
+  			BasicBlock *edge = SplitCriticalEdge(si, k);
+  			if (!edge)
+  				edge = si->getSuccessor(k);
+  			IRBuilder<> Builder(&*edge->getFirstInsertionPt());
+  			emitSiteIncrement(Builder, countersTy, counters, Builder.getInt32(base + k));
+  		}
+  	}
+
+  	/*
+  	 * Sites mode: give the function one i64 counter per successor of each branch site,
+  	 * count the successor taken, and register the counters.
+  	 */
+  	bool instrumentSites(Function &F) {
+  		std::vector<Instruction *> sites;
+  		collectBranchSites(F, sites);
+  		if (sites.empty())
+  			return false;
+
+  		Module *M = F.getParent();
+  		LLVMContext &context = F.getContext();
+  		std::vector<uint32_t> numTargets;
+  		unsigned numCounters = 0;
+  		for (Instruction *site : sites) {
+  			numTargets.push_back(site->getNumSuccessors());
+  			numCounters += site->getNumSuccessors();
+  		}
+
+  		ArrayType *countersTy = ArrayType::get(Type::getInt64Ty(context), numCounters);
+  		GlobalVariable *counters = new GlobalVariable(
+  			*M,
+  			countersTy,
+  			false,
+  			GlobalValue::InternalLinkage,
+  			ConstantAggregateZero::get(countersTy),
+  			"bb.counters");
+  		GlobalVariable *targets = new GlobalVariable(
+  			*M,
+  			ArrayType::get(Type::getInt32Ty(context), numTargets.size()),
+  			true,
+  			GlobalValue::InternalLinkage,
+  			ConstantDataArray::get(context, numTargets),
+  			"bb.targets");
+
+  		// The sites are collected before any edge is split, so the ones of
+  		// collectBranchSites on the uninstrumented function are the same
+  		unsigned base = 0;
+  		for (Instruction *site : sites) {
+  			unsigned numSuccessors = site->getNumSuccessors();
+  			if (BranchInst *bi = dyn_cast<BranchInst>(site)) {
+  				// Successor 0 is taken when the condition is true
+  				IRBuilder<> Builder(bi);
+  				Value *index = Builder.CreateAdd(Builder.getInt32(base),
+  					Builder.CreateZExt(Builder.CreateNot(bi->getCondition()), Builder.getInt32Ty()));
+  				emitSiteIncrement(Builder, countersTy, counters, index);
+  			}
+  			else {
+  				instrumentSwitch(cast<SwitchInst>(site), countersTy, counters, base);
+  			}
+  			base += numSuccessors;
+  		}
+
+  		Constant *registerBranchSites = M->getOrInsertFunction(
+		    "registerBranchSites",               // name of function
+		    Type::getVoidTy(context),        // return type
+		    Type::getInt64Ty(context),		   // function GUID
+		    Type::getInt32Ty(context),		   // number of sites
+		    Type::getInt32PtrTy(context),      // successors of each site
+		    Type::getInt64PtrTy(context)       // counters
+		  );
+
+  		IRBuilder<> Builder(RegisterFunction->getEntryBlock().getTerminator());
+  		std::vector<Value*> args1;
+  		args1.push_back(Builder.getInt64(F.getGUID()));
+  		args1.push_back(Builder.getInt32(sites.size()));
+  		args1.push_back(Builder.CreatePointerCast(targets, Type::getInt32PtrTy(context)));
+  		args1.push_back(Builder.CreatePointerCast(counters, Type::getInt64PtrTy(context)));
+  		Builder.CreateCall(registerBranchSites, args1);
+  		return true;
+  	}
+
   	bool runOnFunction(Function &F) override {
+  		if (BranchBiasMode == BBMode::Sites)
+  			return &F != RegisterFunction && instrumentSites(F);
+  		if (BranchBiasMode == BBMode::Inline)
+  			return &F != DumpFunction && &F != CollectFunction && instrumentInline(F);
 
   		Module *M = F.getParent();
   		LLVMContext &context = F.getContext();
@@ -55,7 +395,7 @@ struct BranchBias : public FunctionPass {
 			}
 
   			for (BasicBlock::iterator I = B->begin(), IE = B->end(); I != IE; ++I) {
-				if((std::string)I->getOpcodeName() == "ret") {
+				if(DumpAtReturn && (std::string)I->getOpcodeName() == "ret") {
 	  					IRBuilder<> Builder(&BB);
 	  					Builder.SetInsertPoint(&*B->getTerminator());
 	  					Builder.CreateCall(printOutBranchInfo);
@@ -66,9 +406,151 @@ struct BranchBias : public FunctionPass {
 	    return false;
   	}
 }; // end of struct TestPass
+
+/*
+ * Attach the branch_weights of a profile written by a -cse231-bb-mode=sites run
+ * to the branch sites it covers.
+ */
+struct BranchBiasAnnotate : public FunctionPass {
+ 	static char ID;
+  	BranchBiasAnnotate() : FunctionPass(ID) {}
+
+  	struct FunctionProfile {
+  		std::vector<uint32_t> NumTargets;
+  		std::vector<uint64_t> Counters;
+  	};
+
+  	std::map<uint64_t, FunctionProfile> Profile;
+
+  	bool doInitialization(Module &) override {
+  		Profile.clear();
+  		ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(BranchProfileFile);
+  		if (!buffer) {
+  			errs() << "warning: cannot read branch profile " << BranchProfileFile << ": "
+  			       << buffer.getError().message() << "\n";
+  			return false;
+  		}
+  		if (!readProfile((*buffer)->getBufferStart(), (*buffer)->getBufferEnd())) {
+  			errs() << "warning: " << BranchProfileFile << " is not a valid branch profile\n";
+  			Profile.clear();
+  		}
+  		return false;
+  	}
+
+  	bool readProfile(const char *data, const char *end) {
+  		cse231::BranchProfileHeader header;
+  		if (end - data < (ptrdiff_t)sizeof(header))
+  			return false;
+  		memcpy(&header, data, sizeof(header));
+  		data += sizeof(header);
+  		if (memcmp(header.Magic, cse231::BranchProfileMagic, sizeof(header.Magic)) != 0 ||
+  		    header.Version != cse231::BranchProfileVersion)
+  			return false;
+
+  		for (uint32_t i = 0; i < header.NumFunctions; ++i) {
+  			cse231::BranchProfileFunction function;
+  			if (end - data < (ptrdiff_t)sizeof(function))
+  				return false;
+  			memcpy(&function, data, sizeof(function));
+  			data += sizeof(function);
+
+  			uint64_t size = uint64_t(function.NumSites) * sizeof(uint32_t) +
+  			                uint64_t(function.NumCounters) * sizeof(uint64_t);
+  			if (uint64_t(end - data) < size)
+  				return false;
+  			FunctionProfile profile;
+  			profile.NumTargets.resize(function.NumSites);
+  			profile.Counters.resize(function.NumCounters);
+  			memcpy(profile.NumTargets.data(), data, function.NumSites * sizeof(uint32_t));
+  			data += function.NumSites * sizeof(uint32_t);
+  			memcpy(profile.Counters.data(), data, function.NumCounters * sizeof(uint64_t));
+  			data += function.NumCounters * sizeof(uint64_t);
+
+  			uint64_t numCounters = 0;
+  			for (uint32_t numTargets : profile.NumTargets)
+  				numCounters += numTargets;
+  			if (numCounters != function.NumCounters)
+  				return false;
+  			addFunctionProfile(function.GUID, profile);
+  		}
+  		return true;
+  	}
+
+  	/*
+  	 * A linkonce_odr function is instrumented in every translation unit that
+  	 * has a copy, and the copies share its GUID. Only the one the linker kept
+  	 * runs, so the counts of records with the same sites are summed. Records
+  	 * with different sites come from different builds of the function: the one
+  	 * that counted more executions is kept.
+  	 */
+  	void addFunctionProfile(uint64_t GUID, FunctionProfile &profile) {
+  		std::map<uint64_t, FunctionProfile>::iterator it = Profile.find(GUID);
+  		if (it == Profile.end()) {
+  			Profile[GUID] = std::move(profile);
+  			return;
+  		}
+  		FunctionProfile &existing = it->second;
+  		if (existing.NumTargets == profile.NumTargets) {
+  			for (size_t k = 0; k < profile.Counters.size(); ++k)
+  				existing.Counters[k] += profile.Counters[k];
+  			return;
+  		}
+  		uint64_t existingTotal = 0, total = 0;
+  		for (uint64_t count : existing.Counters)
+  			existingTotal += count;
+  		for (uint64_t count : profile.Counters)
+  			total += count;
+  		if (total > existingTotal)
+  			existing = std::move(profile);
+  	}
+
+  	bool runOnFunction(Function &F) override {
+  		std::map<uint64_t, FunctionProfile>::iterator it = Profile.find(F.getGUID());
+  		if (it == Profile.end())
+  			return false;
+  		const FunctionProfile &profile = it->second;
+
+  		std::vector<Instruction *> sites;
+  		collectBranchSites(F, sites);
+  		bool matches = sites.size() == profile.NumTargets.size();
+  		for (unsigned i = 0; matches && i < sites.size(); ++i)
+  			matches = sites[i]->getNumSuccessors() == profile.NumTargets[i];
+  		if (!matches) {
+  			errs() << "warning: the branch profile of " << F.getName() << " does not match its CFG\n";
+  			return false;
+  		}
+
+  		MDBuilder builder(F.getContext());
+  		bool changed = false;
+  		unsigned base = 0;
+  		for (Instruction *site : sites) {
+  			unsigned numTargets = site->getNumSuccessors();
+  			uint64_t max = 0;
+  			for (unsigned k = 0; k < numTargets; ++k)
+  				max = std::max(max, profile.Counters[base + k]);
+
+  			// Branch weights are 32-bit: scale all the counts of a site by the same factor
+  			if (max != 0) {
+  				uint64_t scale = max / UINT32_MAX + 1;
+  				std::vector<uint32_t> weights;
+  				for (unsigned k = 0; k < numTargets; ++k)
+  					weights.push_back(profile.Counters[base + k] / scale);
+  				site->setMetadata(LLVMContext::MD_prof, builder.createBranchWeights(weights));
+  				changed = true;
+  			}
+  			base += numTargets;
+  		}
+  		return changed;
+  	}
+}; // end of struct
 }  // end of anonymous namespace
 
 char BranchBias::ID = 0;
 static RegisterPass<BranchBias> X("cse231-bb", "Compute the branch bias on a per-function basis",
                              false /* Only looks at CFG */,
-                             false /* Analysis Pass */);
\ No newline at end of file
+                             false /* Analysis Pass */);
+
+char BranchBiasAnnotate::ID = 0;
+static RegisterPass<BranchBiasAnnotate> Y("cse231-bb-annotate", "Attach the branch weights of a -cse231-bb-mode=sites profile",
+                             false /* Only looks at CFG */,
+                             false /* Analysis Pass */);
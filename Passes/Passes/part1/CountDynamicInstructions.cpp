@@ -1,5 +1,6 @@
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -11,23 +12,391 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <map>
 #include <stdint.h>
+#include <utility>
+#include <vector>
 
 using namespace llvm;
 
+enum class CDIMode { Call, Inline, Block };
+
+static cl::opt<CDIMode> CDIInstrumentation(
+	"cse231-cdi-mode", cl::desc("How -cse231-cdi counts the executed instructions"),
+	cl::values(clEnumValN(CDIMode::Call, "call", "call updateInstrInfo at the end of every basic block"),
+	           clEnumValN(CDIMode::Inline, "inline", "add to a per-opcode counter array in the IR, report once at exit"),
+	           clEnumValN(CDIMode::Block, "block", "count basic blocks only, rebuild the opcode counts at exit")),
+	cl::init(CDIMode::Call));
+
+static cl::opt<bool> CDIAtomic("cse231-cdi-atomic",
+                               cl::desc("Use atomic increments in the inline and block modes of -cse231-cdi, for multithreaded programs"),
+                               cl::init(false));
+
 namespace {
 struct CountDynamicInstructions : public FunctionPass {
  	static char ID;
   	CountDynamicInstructions() : FunctionPass(ID) {}
 
+  	// Opcode histogram of a basic block, as the (keys, values) arrays passed to updateInstrInfo
+  	typedef std::pair<std::vector<uint32_t>, std::vector<uint32_t>> Histogram;
+
+  	// Constant key/value arrays already emitted in the current module, shared by all
+  	// the blocks with the same histogram
+  	std::map<Histogram, std::pair<GlobalVariable *, GlobalVariable *>> HistogramArrays;
+
+  	// Inline and block modes: one i32 counter per opcode, and the function reporting them at exit
+  	GlobalVariable *Counters = nullptr;
+  	Function *DumpFunction = nullptr;
+  	// Block mode: adds the block counts of one function to Counters, see createCollectFunction
+  	Function *CollectFunction = nullptr;
+
+  	bool doInitialization(Module &M) override {
+  		HistogramArrays.clear();
+  		Counters = nullptr;
+  		DumpFunction = nullptr;
+  		CollectFunction = nullptr;
+  		if (CDIInstrumentation == CDIMode::Call)
+  			return false;
+
+  		LLVMContext &context = M.getContext();
+  		ArrayType *countersTy = ArrayType::get(Type::getInt32Ty(context), Instruction::OtherOpsEnd);
+  		Counters = new GlobalVariable(
+  			M,
+  			countersTy,
+  			false,
+  			GlobalValue::InternalLinkage,
+  			ConstantAggregateZero::get(countersTy),
+  			"cdi.counters");
+  		DumpFunction = createDumpFunction(M);
+  		appendToGlobalDtors(M, DumpFunction, 0);
+  		if (CDIInstrumentation == CDIMode::Block)
+  			CollectFunction = createCollectFunction(M);
+  		return true;
+  	}
+
+  	/*
+  	 * Build the function that turns block counts back into opcode counts:
+  	 *
+  	 *   void cdi.collect(i32 *table, i32 n, i32 *blocks)
+  	 *     for (i = 0; i < n; ++i)
+  	 *       counters[table[3*i+1]] += blocks[table[3*i]] * table[3*i+2];
+  	 *
+  	 * table is the side table of a function: n (counter, opcode, count) triples saying
+  	 * that every increment of counter stands for count instructions of that opcode.
+  	 * n must not be 0.
+  	 */
+  	Function *createCollectFunction(Module &M) {
+  		LLVMContext &context = M.getContext();
+  		Type *int32Ty = Type::getInt32Ty(context);
+  		Type *int32PtrTy = Type::getInt32PtrTy(context);
+
+  		Function *collect = Function::Create(
+  			FunctionType::get(Type::getVoidTy(context), {int32PtrTy, int32Ty, int32PtrTy}, false),
+  			GlobalValue::InternalLinkage, "cdi.collect", &M);
+  		Function::arg_iterator args = collect->arg_begin();
+  		Value *table = &*args++;
+  		Value *n = &*args++;
+  		Value *blocks = &*args++;
+  		BasicBlock *entry = BasicBlock::Create(context, "entry", collect);
+  		BasicBlock *loop = BasicBlock::Create(context, "loop", collect);
+  		BasicBlock *exit = BasicBlock::Create(context, "exit", collect);
+
+  		IRBuilder<> Builder(entry);
+  		Builder.CreateBr(loop);
+
+  		Builder.SetInsertPoint(loop);
+  		PHINode *i = Builder.CreatePHI(int32Ty, 2, "i");
+  		i->addIncoming(Builder.getInt32(0), entry);
+  		Value *base = Builder.CreateMul(i, Builder.getInt32(3));
+  		Value *field[3];
+  		for (unsigned k = 0; k < 3; ++k) {
+  			Value *slot = Builder.CreateInBoundsGEP(int32Ty, table, Builder.CreateAdd(base, Builder.getInt32(k)));
+  			field[k] = Builder.CreateLoad(int32Ty, slot);
+  		}
+  		Value *executions = Builder.CreateLoad(int32Ty, Builder.CreateInBoundsGEP(int32Ty, blocks, field[0]));
+  		Value *counter = Builder.CreateInBoundsGEP(Counters->getValueType(), Counters,
+  		                                           {Builder.getInt32(0), field[1]});
+  		Value *count = Builder.CreateLoad(int32Ty, counter);
+  		Builder.CreateStore(Builder.CreateAdd(count, Builder.CreateMul(executions, field[2])), counter);
+  		Value *next = Builder.CreateAdd(i, Builder.getInt32(1));
+  		i->addIncoming(next, loop);
+  		Builder.CreateCondBr(Builder.CreateICmpEQ(next, n), exit, loop);
+
+  		Builder.SetInsertPoint(exit);
+  		Builder.CreateRetVoid();
+  		return collect;
+  	}
+
+  	/*
+  	 * Build the function run at exit in inline and block modes. It hands every nonzero counter
+  	 * to updateInstrInfo, one opcode at a time, then calls printOutInstrInfo:
+  	 *
+  	 *   for (i = 0; i < OtherOpsEnd; ++i)
+  	 *     if (counters[i] != 0) { key = i; value = counters[i]; updateInstrInfo(1, &key, &value); }
+  	 *   printOutInstrInfo();
+  	 */
+  	Function *createDumpFunction(Module &M) {
+  		LLVMContext &context = M.getContext();
+  		Type *int32Ty = Type::getInt32Ty(context);
+
+  		Constant *updateInstrInfo = M.getOrInsertFunction(
+		    "updateInstrInfo",               // name of function
+		    Type::getVoidTy(context),        // return type
+		    Type::getInt32Ty(context),		   // first parameter type
+		    Type::getInt32PtrTy(context),      // second parameter type
+		    Type::getInt32PtrTy(context)       // third parameter type
+		  );
+
+  		Constant *printOutInstrInfo = M.getOrInsertFunction(
+		    "printOutInstrInfo",               // name of function
+		    Type::getVoidTy(context)        // return type
+		  );
+
+  		Function *dump = Function::Create(FunctionType::get(Type::getVoidTy(context), false),
+  		                                  GlobalValue::InternalLinkage, "cdi.dump", &M);
+  		BasicBlock *entry = BasicBlock::Create(context, "entry", dump);
+  		BasicBlock *loop = BasicBlock::Create(context, "loop", dump);
+  		BasicBlock *report = BasicBlock::Create(context, "report", dump);
+  		BasicBlock *latch = BasicBlock::Create(context, "latch", dump);
+  		BasicBlock *exit = BasicBlock::Create(context, "exit", dump);
+
+  		IRBuilder<> Builder(entry);
+  		Value *key = Builder.CreateAlloca(int32Ty, nullptr, "key");
+  		Value *value = Builder.CreateAlloca(int32Ty, nullptr, "value");
+  		Builder.CreateBr(loop);
+
+  		Builder.SetInsertPoint(loop);
+  		PHINode *opcode = Builder.CreatePHI(int32Ty, 2, "opcode");
+  		opcode->addIncoming(Builder.getInt32(0), entry);
+  		Value *counter = Builder.CreateInBoundsGEP(Counters->getValueType(), Counters,
+  		                                           {Builder.getInt32(0), opcode});
+  		Value *count = Builder.CreateLoad(int32Ty, counter);
+  		Builder.CreateCondBr(Builder.CreateICmpNE(count, Builder.getInt32(0)), report, latch);
+
+  		Builder.SetInsertPoint(report);
+  		Builder.CreateStore(opcode, key);
+  		Builder.CreateStore(count, value);
+  		std::vector<Value*> args1;
+  		args1.push_back(Builder.getInt32(1));
+  		args1.push_back(key);
+  		args1.push_back(value);
+  		Builder.CreateCall(updateInstrInfo, args1);
+  		Builder.CreateBr(latch);
+
+  		Builder.SetInsertPoint(latch);
+  		Value *next = Builder.CreateAdd(opcode, Builder.getInt32(1));
+  		opcode->addIncoming(next, latch);
+  		Value *done = Builder.CreateICmpEQ(next, Builder.getInt32(Instruction::OtherOpsEnd));
+  		Builder.CreateCondBr(done, exit, loop);
+
+  		Builder.SetInsertPoint(exit);
+  		Builder.CreateCall(printOutInstrInfo);
+  		Builder.CreateRetVoid();
+  		return dump;
+  	}
+
+  	/*
+  	 * Count the opcodes of a basic block, in increasing opcode order.
+  	 */
+  	static Histogram countOpcodes(BasicBlock &BB) {
+  		std::map<uint32_t, uint32_t> counts;
+  		for (BasicBlock::iterator I = BB.begin(), IE = BB.end(); I != IE; ++I)
+  			counts[I->getOpcode()]++;
+
+  		Histogram histogram;
+  		for (std::map<uint32_t, uint32_t>::iterator it = counts.begin(); it != counts.end(); ++it) {
+  			histogram.first.push_back(it->first);
+  			histogram.second.push_back(it->second);
+  		}
+  		return histogram;
+  	}
+
+  	/*
+  	 * Return the key and value arrays of histogram, creating them the first time
+  	 * the histogram is seen in the module.
+  	 */
+  	std::pair<GlobalVariable *, GlobalVariable *> getHistogramArrays(Module *M, const Histogram &histogram) {
+  		std::map<Histogram, std::pair<GlobalVariable *, GlobalVariable *>>::iterator it = HistogramArrays.find(histogram);
+  		if (it != HistogramArrays.end())
+  			return it->second;
+
+  		LLVMContext &context = M->getContext();
+  		ArrayType* arrayTy = ArrayType::get(IntegerType::get(context,32), histogram.first.size());
+
+		GlobalVariable *keyArray = new GlobalVariable(
+			    *M,
+			    arrayTy,
+			    true,
+			    GlobalValue::InternalLinkage,
+			    ConstantDataArray::get(context, histogram.first),
+			    "keyArray");
+		GlobalVariable *valueArray = new GlobalVariable(
+		    *M,
+		    arrayTy,
+		    true,
+		    GlobalValue::InternalLinkage,
+		    ConstantDataArray::get(context, histogram.second),
+		    "valueArray");
+
+		std::pair<GlobalVariable *, GlobalVariable *> arrays = std::make_pair(keyArray, valueArray);
+		HistogramArrays[histogram] = arrays;
+		return arrays;
+  	}
+
+  	/*
+  	 * Add amount to the i32 counter, atomically if -cse231-cdi-atomic is set.
+  	 */
+  	static void emitIncrement(IRBuilder<> &Builder, Value *counter, uint32_t amount) {
+  		Value *increment = Builder.getInt32(amount);
+  		if (CDIAtomic) {
+  			Builder.CreateAtomicRMW(AtomicRMWInst::Add, counter, increment, AtomicOrdering::Monotonic);
+  		}
+  		else {
+  			Value *count = Builder.CreateLoad(Builder.getInt32Ty(), counter);
+  			Builder.CreateStore(Builder.CreateAdd(count, increment), counter);
+  		}
+  	}
+
+  	/*
+  	 * Inline mode: add the histogram of the block to the counters before its terminator.
+  	 */
+  	void instrumentInline(BasicBlock &BB, const Histogram &histogram) {
+  		IRBuilder<> Builder(BB.getTerminator());
+  		for (unsigned i = 0; i < histogram.first.size(); ++i) {
+  			Value *counter = Builder.CreateConstInBoundsGEP2_32(Counters->getValueType(), Counters,
+  			                                                    0, histogram.first[i]);
+  			emitIncrement(Builder, counter, histogram.second[i]);
+  		}
+  	}
+
+  	static bool hasCall(BasicBlock &BB) {
+  		for (Instruction &I : BB) {
+  			if ((isa<CallInst>(I) && !isa<DbgInfoIntrinsic>(I)) || isa<InvokeInst>(I))
+  				return true;
+  		}
+  		return false;
+  	}
+
+  	/*
+  	 * Block mode: give each chain of blocks one counter and record which opcodes an
+  	 * increment of it stands for.
+  	 *
+  	 * A block whose only predecessor ends in an unconditional branch to it runs exactly
+  	 * as often as that predecessor, so the two share a counter. The counter is
+  	 * incremented before the terminator of the first block of the chain, and the side
+  	 * table holds the summed histogram of the whole chain. cdi.dump rebuilds the opcode
+  	 * counts from the counters and the table at exit.
+  	 *
+  	 * A call may not return (exit, abort, longjmp, an exception), so a block with one
+  	 * starts a new chain: it is counted at its own terminator, after the call, as the
+  	 * call and inline modes count it.
+  	 */
+  	void instrumentBlocks(Function &F) {
+  		Module *M = F.getParent();
+  		LLVMContext &context = F.getContext();
+
+  		// Chain head of every block, found by following single predecessors
+  		std::map<BasicBlock *, BasicBlock *> head;
+  		for (BasicBlock &BB : F) {
+  			std::vector<BasicBlock *> chain;
+  			BasicBlock *current = &BB;
+  			while (!head.count(current)) {
+  				chain.push_back(current);
+  				BasicBlock *pred = current->getSinglePredecessor();
+  				BranchInst *br = pred ? dyn_cast<BranchInst>(pred->getTerminator()) : nullptr;
+  				if (current == &F.getEntryBlock() || !br || br->isConditional() || hasCall(*current) ||
+  				    std::find(chain.begin(), chain.end(), pred) != chain.end()) {
+  					// current starts a chain (a cycle of such blocks is only reachable
+  					// from itself, so it is cut anywhere)
+  					head[current] = current;
+  					break;
+  				}
+  				current = pred;
+  			}
+  			for (BasicBlock *block : chain)
+  				head[block] = head[current];
+  		}
+
+  		// Counter id of each chain head, and the summed histogram of each chain
+  		std::map<BasicBlock *, unsigned> counterId;
+  		std::vector<BasicBlock *> heads;
+  		std::vector<std::map<uint32_t, uint32_t>> chainCounts;
+  		for (BasicBlock &BB : F) {
+  			BasicBlock *h = head[&BB];
+  			if (!counterId.count(h)) {
+  				counterId[h] = heads.size();
+  				heads.push_back(h);
+  				chainCounts.push_back(std::map<uint32_t, uint32_t>());
+  			}
+  			Histogram histogram = countOpcodes(BB);
+  			for (unsigned i = 0; i < histogram.first.size(); ++i)
+  				chainCounts[counterId[h]][histogram.first[i]] += histogram.second[i];
+  		}
+
+  		std::vector<uint32_t> table;
+  		for (unsigned id = 0; id < chainCounts.size(); ++id) {
+  			for (std::map<uint32_t, uint32_t>::iterator it = chainCounts[id].begin(); it != chainCounts[id].end(); ++it) {
+  				table.push_back(id);
+  				table.push_back(it->first);
+  				table.push_back(it->second);
+  			}
+  		}
+
+  		ArrayType *blocksTy = ArrayType::get(Type::getInt32Ty(context), heads.size());
+  		GlobalVariable *blocks = new GlobalVariable(
+  			*M,
+  			blocksTy,
+  			false,
+  			GlobalValue::InternalLinkage,
+  			ConstantAggregateZero::get(blocksTy),
+  			"cdi.blocks");
+  		GlobalVariable *tableArray = new GlobalVariable(
+  			*M,
+  			ArrayType::get(Type::getInt32Ty(context), table.size()),
+  			true,
+  			GlobalValue::InternalLinkage,
+  			ConstantDataArray::get(context, table),
+  			"cdi.table");
+
+  		for (unsigned id = 0; id < heads.size(); ++id) {
+  			IRBuilder<> Builder(heads[id]->getTerminator());
+  			emitIncrement(Builder, Builder.CreateConstInBoundsGEP2_32(blocksTy, blocks, 0, id), 1);
+  		}
+
+  		// Have cdi.dump collect this function before it reports
+  		IRBuilder<> Builder(DumpFunction->getEntryBlock().getTerminator());
+  		std::vector<Value*> args1;
+  		args1.push_back(Builder.CreatePointerCast(tableArray, Type::getInt32PtrTy(context)));
+  		args1.push_back(Builder.getInt32(table.size() / 3));
+  		args1.push_back(Builder.CreatePointerCast(blocks, Type::getInt32PtrTy(context)));
+  		Builder.CreateCall(CollectFunction, args1);
+  	}
+
   	bool runOnFunction(Function &F) override {
+  		if (&F == DumpFunction || &F == CollectFunction)
+  			return false;
 
   		Module *M = F.getParent();
   		LLVMContext &context = F.getContext();
 
+  		if (CDIInstrumentation == CDIMode::Inline) {
+  			for (BasicBlock &BB : F)
+  				instrumentInline(BB, countOpcodes(BB));
+  			return true;
+  		}
+  		if (CDIInstrumentation == CDIMode::Block) {
+  			instrumentBlocks(F);
+  			return true;
+  		}
+
   		Constant *updateInstrInfo = M->getOrInsertFunction(
 		    "updateInstrInfo",               // name of function
 		    Type::getVoidTy(context),        // return type
@@ -44,54 +413,28 @@ struct CountDynamicInstructions : public FunctionPass {
   		for(Function::iterator B = F.begin(), BE = F.end(); B != BE; B++) {
 
   			BasicBlock &BB = *B;
-  			std::vector<uint32_t> keys;
-  			std::vector<uint32_t> values;
-
-  			for (BasicBlock::iterator I = B->begin(), IE = B->end(); I != IE; ++I) {
-  				keys.push_back(I->getOpcode());
-  				values.push_back(1);
-			}
+  			Histogram histogram = countOpcodes(BB);
+  			std::pair<GlobalVariable *, GlobalVariable *> arrays = getHistogramArrays(M, histogram);
 
 			IRBuilder<> Builder(&BB);
 			Builder.SetInsertPoint(&*B->getTerminator());
 			std::vector<Value*> args1;
-  			Constant* num = ConstantInt::get(IntegerType::get(context,32), keys.size());
-
-  			ArrayType* arrayTy = ArrayType::get(IntegerType::get(context,32), keys.size());
-
-			GlobalVariable *keyArray = new GlobalVariable(
-				    *M,
-				    arrayTy,
-				    true,
-				    GlobalValue::InternalLinkage,
-				    ConstantDataArray::get(context, keys),
-				    "keyArray");
-			GlobalVariable *valueArray = new GlobalVariable(
-			    *M,
-			    arrayTy,
-			    true,
-			    GlobalValue::InternalLinkage,
-			    ConstantDataArray::get(context, values),
-			    "valueArray");
+  			Constant* num = ConstantInt::get(IntegerType::get(context,32), histogram.first.size());
 
-			Value* keyValue = Builder.CreatePointerCast(keyArray, Type::getInt32PtrTy(context));
-			Value* valueValue = Builder.CreatePointerCast(valueArray, Type::getInt32PtrTy(context));
+			Value* keyValue = Builder.CreatePointerCast(arrays.first, Type::getInt32PtrTy(context));
+			Value* valueValue = Builder.CreatePointerCast(arrays.second, Type::getInt32PtrTy(context));
 
 			args1.push_back(num);
 			args1.push_back(keyValue);
 			args1.push_back(valueValue);
 			Builder.CreateCall(updateInstrInfo, args1);
 
-  			for (BasicBlock::iterator I = B->begin(), IE = B->end(); I != IE; ++I) {
-				if((std::string)I->getOpcodeName() == "ret") {
-	  					IRBuilder<> Builder(&BB);
-	  					Builder.SetInsertPoint(&*B->getTerminator());
-	  					Builder.CreateCall(printOutInstrInfo);
-	  			}
-	  		}
+			if(DumpAtReturn && isa<ReturnInst>(B->getTerminator())) {
+				Builder.CreateCall(printOutInstrInfo);
+			}
   		}
-  		
-	    return false;
+
+	    return true;
   	}
 }; // end of struct TestPass
 }  // end of anonymous namespace
@@ -99,4 +442,4 @@ struct CountDynamicInstructions : public FunctionPass {
 char CountDynamicInstructions::ID = 0;
 static RegisterPass<CountDynamicInstructions> X("cse231-cdi", "Count the occurrence of each instruction dynamically",
                              false /* Only looks at CFG */,
-                             false /* Analysis Pass */);
\ No newline at end of file
+                             false /* Analysis Pass */);
@@ -0,0 +1,21 @@
+//===- Instrumentation.cpp - Options shared by the CSE 231 passes ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the command line options shared by the instrumentation
+// passes of part 1.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Instrumentation.h"
+
+using namespace llvm;
+
+cl::opt<bool> llvm::DumpAtReturn("cse231-dump-at-return",
+                                 cl::desc("Print the profile of the runtime before every return"),
+                                 cl::init(true));
@@ -0,0 +1,28 @@
+//===- Instrumentation.h - Options shared by the CSE 231 passes -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the command line options shared by the instrumentation
+// passes of part 1.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231_INSTRUMENTATION_H
+#define LLVM_TRANSFORMS_231_INSTRUMENTATION_H
+
+#include "llvm/Support/CommandLine.h"
+
+namespace llvm {
+
+// Set by -cse231-dump-at-return: call the printOut function of the runtime
+// before every return. The runtime in Passes/Runtime reports once at exit on
+// its own, so this is only needed with runtimes that do not.
+extern cl::opt<bool> DumpAtReturn;
+
+}
+#endif // End LLVM_TRANSFORMS_231_INSTRUMENTATION_H
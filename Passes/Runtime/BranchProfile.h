@@ -0,0 +1,47 @@
+//===- BranchProfile.h - Layout of the CSE 231 branch profile -------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file describes the binary branch profile written at exit by lib231 for
+// programs instrumented with -cse231-bb-mode=sites and read back by
+// -cse231-bb-annotate. It is shared by the runtime and the passes, so it only
+// uses the C++ standard library.
+//
+// The file is a BranchProfileHeader followed by NumFunctions records. A record
+// is a BranchProfileFunction, then NumSites uint32_t successor counts (one per
+// branch site, in site order), then NumCounters uint64_t execution counts (the
+// successors of every site, site after site). Integers are in the byte order
+// of the machine that ran the program.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_231_BRANCHPROFILE_H
+#define LLVM_TRANSFORMS_231_BRANCHPROFILE_H
+
+#include <stdint.h>
+
+namespace cse231 {
+
+const char BranchProfileMagic[8] = {'C', 'S', 'E', '2', '3', '1', 'B', 'P'};
+const uint32_t BranchProfileVersion = 1;
+
+struct BranchProfileHeader {
+  char Magic[8];
+  uint32_t Version;
+  uint32_t NumFunctions;
+};
+
+struct BranchProfileFunction {
+  // Function::getGUID() of the instrumented function
+  uint64_t GUID;
+  uint32_t NumSites;
+  uint32_t NumCounters;
+};
+
+}
+#endif // End LLVM_TRANSFORMS_231_BRANCHPROFILE_H
@@ -0,0 +1,275 @@
+//===- lib231.cpp - Runtime of the CSE 231 instrumentation passes ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the functions called by the code that -cse231-cdi and
+// -cse231-bb insert. It is linked into the instrumented program and does not
+// depend on LLVM.
+//
+// Every thread counts into its own shard, so the hot path takes no lock and
+// does no atomic read-modify-write. Shards are never freed: the counts of a
+// thread that has exited are still reported. The printOut functions merge all
+// the shards and print what was counted since the previous report. One last
+// report is printed when the process exits, so the passes do not have to dump
+// at every return (see -cse231-dump-at-return).
+//
+// Programs instrumented with -cse231-bb-mode=sites register their per-site
+// counters instead; they are written to a binary profile at exit (see
+// BranchProfile.h).
+//
+//===----------------------------------------------------------------------===//
+
+#include "BranchProfile.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace {
+
+// Names of the LLVM 5.0 opcodes, indexed by Instruction::getOpcode()
+const char *const OpcodeNames[] = {
+  "<Invalid operator> ", "ret", "br", "switch", "indirectbr", "invoke", "resume",
+  "unreachable", "cleanupret", "catchret", "catchswitch", "add", "fadd", "sub",
+  "fsub", "mul", "fmul", "udiv", "sdiv", "fdiv", "urem", "srem", "frem", "shl",
+  "lshr", "ashr", "and", "or", "xor", "alloca", "load", "store", "getelementptr",
+  "fence", "cmpxchg", "atomicrmw", "trunc", "zext", "sext", "fptoui", "fptosi",
+  "uitofp", "sitofp", "fptrunc", "fpext", "ptrtoint", "inttoptr", "bitcast",
+  "addrspacecast", "cleanuppad", "catchpad", "icmp", "fcmp", "phi", "call",
+  "select", "<Invalid operator> ", "<Invalid operator> ", "va_arg",
+  "extractelement", "insertelement", "shufflevector", "extractvalue",
+  "insertvalue", "landingpad"};
+
+const unsigned NumOpcodeNames = sizeof(OpcodeNames) / sizeof(OpcodeNames[0]);
+
+// Opcodes past the table are still counted, up to this bound
+const unsigned MaxOpcodes = 128;
+
+const char *getOpcodeName(unsigned opcode) {
+  return opcode < NumOpcodeNames ? OpcodeNames[opcode] : "<Invalid operator> ";
+}
+
+/*
+ * The counters of one thread. Only the owning thread writes them; the reports
+ * read them from whichever thread prints.
+ */
+struct Shard {
+  std::atomic<uint64_t> Instrs[MaxOpcodes];
+  std::atomic<uint64_t> Taken;
+  std::atomic<uint64_t> Total;
+  Shard *Next;
+};
+
+// All the shards ever created, pushed without locking
+std::atomic<Shard *> Shards(nullptr);
+
+thread_local Shard *LocalShard = nullptr;
+
+// Totals already printed by a report, guarded by ReportMutex
+std::mutex ReportMutex;
+uint64_t ReportedInstrs[MaxOpcodes];
+uint64_t ReportedTaken;
+uint64_t ReportedTotal;
+
+Shard *getShard() {
+  Shard *shard = LocalShard;
+  if (shard)
+    return shard;
+
+  shard = new Shard();
+  Shard *head = Shards.load(std::memory_order_relaxed);
+  do {
+    shard->Next = head;
+  } while (!Shards.compare_exchange_weak(head, shard, std::memory_order_release,
+                                         std::memory_order_relaxed));
+  LocalShard = shard;
+  return shard;
+}
+
+// Add to a counter of the calling thread's own shard. No other thread writes
+// it, so a plain load and store is enough.
+inline void bump(std::atomic<uint64_t> &counter, uint64_t amount) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount,
+                std::memory_order_relaxed);
+}
+
+/*
+ * Print the instructions counted since the last report, one "name\tcount" line
+ * per opcode in opcode order. Returns false without printing if there are none
+ * and force is false. ReportMutex must be held.
+ */
+bool reportInstrs(bool force) {
+  uint64_t totals[MaxOpcodes] = {0};
+  for (Shard *shard = Shards.load(std::memory_order_acquire); shard; shard = shard->Next)
+    for (unsigned op = 0; op < MaxOpcodes; ++op)
+      totals[op] += shard->Instrs[op].load(std::memory_order_relaxed);
+
+  bool any = false;
+  for (unsigned op = 0; op < MaxOpcodes; ++op)
+    any |= totals[op] != ReportedInstrs[op];
+  if (!any && !force)
+    return false;
+
+  for (unsigned op = 0; op < MaxOpcodes; ++op) {
+    uint64_t count = totals[op] - ReportedInstrs[op];
+    if (count)
+      fprintf(stderr, "%s\t%llu\n", getOpcodeName(op), (unsigned long long)count);
+    ReportedInstrs[op] = totals[op];
+  }
+  return true;
+}
+
+/*
+ * Print the branches counted since the last report as "taken\tN\ntotal\tN".
+ * Returns false without printing if there are none and force is false.
+ * ReportMutex must be held.
+ */
+bool reportBranches(bool force) {
+  uint64_t taken = 0, total = 0;
+  for (Shard *shard = Shards.load(std::memory_order_acquire); shard; shard = shard->Next) {
+    taken += shard->Taken.load(std::memory_order_relaxed);
+    total += shard->Total.load(std::memory_order_relaxed);
+  }
+  if (total == ReportedTotal && !force)
+    return false;
+
+  fprintf(stderr, "taken\t%llu\n", (unsigned long long)(taken - ReportedTaken));
+  fprintf(stderr, "total\t%llu\n", (unsigned long long)(total - ReportedTotal));
+  ReportedTaken = taken;
+  ReportedTotal = total;
+  return true;
+}
+
+/*
+ * The branch site counters of one instrumented function, as registered by the
+ * constructor of its module.
+ */
+struct BranchSiteTable {
+  uint64_t GUID;
+  uint32_t NumSites;
+  const uint32_t *NumTargets;
+  const uint64_t *Counters;
+  BranchSiteTable *Next;
+};
+
+// Guarded by ReportMutex
+BranchSiteTable *BranchSites = nullptr;
+unsigned NumBranchSiteTables = 0;
+
+/*
+ * Write the registered branch site counters to the file named by
+ * $CSE231_BRANCH_PROFILE, or cse231.prof. ReportMutex must be held.
+ */
+void writeBranchProfile() {
+  if (!BranchSites)
+    return;
+  const char *path = getenv("CSE231_BRANCH_PROFILE");
+  if (!path)
+    path = "cse231.prof";
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "lib231: cannot write the branch profile to %s\n", path);
+    return;
+  }
+
+  cse231::BranchProfileHeader header;
+  for (unsigned i = 0; i < sizeof(header.Magic); ++i)
+    header.Magic[i] = cse231::BranchProfileMagic[i];
+  header.Version = cse231::BranchProfileVersion;
+  header.NumFunctions = NumBranchSiteTables;
+  fwrite(&header, sizeof(header), 1, file);
+
+  for (BranchSiteTable *table = BranchSites; table; table = table->Next) {
+    cse231::BranchProfileFunction function;
+    function.GUID = table->GUID;
+    function.NumSites = table->NumSites;
+    function.NumCounters = 0;
+    for (uint32_t site = 0; site < table->NumSites; ++site)
+      function.NumCounters += table->NumTargets[site];
+    fwrite(&function, sizeof(function), 1, file);
+    fwrite(table->NumTargets, sizeof(uint32_t), function.NumSites, file);
+    fwrite(table->Counters, sizeof(uint64_t), function.NumCounters, file);
+  }
+  fclose(file);
+}
+
+void reportAtExit() {
+  std::lock_guard<std::mutex> lock(ReportMutex);
+  reportInstrs(false);
+  reportBranches(false);
+  writeBranchProfile();
+}
+
+struct ExitReporter {
+  ExitReporter() { std::atexit(reportAtExit); }
+} Reporter;
+
+} // end of anonymous namespace
+
+extern "C" {
+
+/*
+ * Count values[i] executions of opcode keys[i], for i < num.
+ */
+void updateInstrInfo(unsigned num, uint32_t *keys, uint32_t *values) {
+  Shard *shard = getShard();
+  for (unsigned i = 0; i < num; ++i)
+    if (keys[i] < MaxOpcodes)
+      bump(shard->Instrs[keys[i]], values[i]);
+}
+
+void printOutInstrInfo() {
+  std::lock_guard<std::mutex> lock(ReportMutex);
+  reportInstrs(true);
+}
+
+/*
+ * Count one execution of a conditional branch.
+ */
+void updateBranchInfo(bool taken) {
+  Shard *shard = getShard();
+  bump(shard->Total, 1);
+  if (taken)
+    bump(shard->Taken, 1);
+}
+
+/*
+ * Count total conditional branches at once, taken of which were taken.
+ */
+void addBranchInfo(uint64_t taken, uint64_t total) {
+  Shard *shard = getShard();
+  bump(shard->Total, total);
+  bump(shard->Taken, taken);
+}
+
+void printOutBranchInfo() {
+  std::lock_guard<std::mutex> lock(ReportMutex);
+  reportBranches(true);
+}
+
+/*
+ * Record where the branch site counters of a function live, so they can be
+ * written to the profile at exit. counters holds numTargets[i] entries for
+ * each site i, one per successor in successor order.
+ */
+void registerBranchSites(uint64_t guid, uint32_t numSites, const uint32_t *numTargets,
+                         uint64_t *counters) {
+  BranchSiteTable *table = new BranchSiteTable();
+  table->GUID = guid;
+  table->NumSites = numSites;
+  table->NumTargets = numTargets;
+  table->Counters = counters;
+
+  std::lock_guard<std::mutex> lock(ReportMutex);
+  table->Next = BranchSites;
+  BranchSites = table;
+  NumBranchSiteTables++;
+}
+
+}
@@ -0,0 +1,43 @@
+// Expressions computed more than once, with the cases the elimination must
+// get right.
+
+// b2 only recomputes b1 once a2 is replaced by a1, in a second round
+int rounds(int x, int y) {
+	int a1 = x + y;
+	int b1 = a1 * 2;
+	int a2 = y + x;
+	int b2 = a2 * 2;
+	return b1 - b2 + b2;
+}
+
+// x * 3 is computed before the loop, so the loop need not recompute it. i + 1
+// and i * x are only computed later in the iteration, or on one path through
+// it, so they are not available where the loop recomputes them
+int loop(int x, int n) {
+	int pre = x * 3;
+	int acc = 0;
+	for (int i = 0; i < n; ++i) {
+		int again = i + 1;
+		acc += x * 3 + again;
+		if (i % 2 == 0)
+			acc += i * x;
+		acc += i * x;
+	}
+	return acc + pre;
+}
+
+int values[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+// s1 is an add nsw and g1 an inbounds getelementptr, their copies s2 and g2
+// have no flags: s1 and g1 stand for both, so they lose theirs
+int flags(int x, int y) {
+	int s1 = x + y;             // add nsw
+	int *g1 = &values[s1];      // getelementptr inbounds
+	unsigned s2 = (unsigned)x + y;
+	int *g2 = (int *)((char *)values + s2 * sizeof(int));
+	return *g1 + *g2;
+}
+
+int main() {
+	return rounds(3, 4) + loop(2, 5) + flags(1, 2);
+}
@@ -0,0 +1,74 @@
+; CommonSubexpressions.cpp after mem2reg (clang++ -O0 -Xclang
+; -disable-O0-optnone, then opt -mem2reg -instnamer), with the loop rotated and
+; the pointer arithmetic of flags written as plain getelementptrs.
+
+@values = global [8 x i32] [i32 1, i32 2, i32 3, i32 4, i32 5, i32 6, i32 7, i32 8], align 16
+
+define i32 @_Z6roundsii(i32 %x, i32 %y) {
+entry:
+  %a1 = add nsw i32 %x, %y
+  %b1 = mul nsw i32 %a1, 2
+  %a2 = add nsw i32 %y, %x
+  %b2 = mul nsw i32 %a2, 2
+  %sub = sub nsw i32 %b1, %b2
+  %add = add nsw i32 %sub, %b2
+  ret i32 %add
+}
+
+define i32 @_Z4loopii(i32 %x, i32 %n) {
+entry:
+  %pre = mul nsw i32 %x, 3
+  %cmp.entry = icmp slt i32 0, %n
+  br i1 %cmp.entry, label %for.body, label %for.end
+
+for.body:
+  %i = phi i32 [ 0, %entry ], [ %inc, %if.end ]
+  %acc = phi i32 [ 0, %entry ], [ %acc3, %if.end ]
+  %again = add nsw i32 %i, 1
+  %mul = mul nsw i32 %x, 3
+  %add = add nsw i32 %mul, %again
+  %acc1 = add nsw i32 %acc, %add
+  %rem = srem i32 %i, 2
+  %cmp = icmp eq i32 %rem, 0
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:
+  %even = mul nsw i32 %i, %x
+  %acc2 = add nsw i32 %acc1, %even
+  br label %if.end
+
+if.end:
+  %acc.if = phi i32 [ %acc2, %if.then ], [ %acc1, %for.body ]
+  %every = mul nsw i32 %i, %x
+  %acc3 = add nsw i32 %acc.if, %every
+  %inc = add nsw i32 %i, 1
+  %cmp.latch = icmp slt i32 %inc, %n
+  br i1 %cmp.latch, label %for.body, label %for.end
+
+for.end:
+  %acc.end = phi i32 [ 0, %entry ], [ %acc3, %if.end ]
+  %result = add nsw i32 %acc.end, %pre
+  ret i32 %result
+}
+
+define i32 @_Z5flagsii(i32 %x, i32 %y) {
+entry:
+  %s1 = add nsw i32 %x, %y
+  %g1 = getelementptr inbounds [8 x i32], [8 x i32]* @values, i32 0, i32 %s1
+  %s2 = add i32 %x, %y
+  %g2 = getelementptr [8 x i32], [8 x i32]* @values, i32 0, i32 %s2
+  %v1 = load i32, i32* %g1, align 4
+  %v2 = load i32, i32* %g2, align 4
+  %add = add nsw i32 %v1, %v2
+  ret i32 %add
+}
+
+define i32 @main() {
+entry:
+  %call = call i32 @_Z6roundsii(i32 3, i32 4)
+  %call1 = call i32 @_Z4loopii(i32 2, i32 5)
+  %add = add nsw i32 %call, %call1
+  %call2 = call i32 @_Z5flagsii(i32 1, i32 2)
+  %add3 = add nsw i32 %add, %call2
+  ret i32 %add3
+}
@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# path to opt and lli
+LLVM_BIN=/LLVM_ROOT/build/bin
+# path to CSE231-DFA.so
+LLVM_SO=/LLVM_ROOT/build/lib
+# path to the test directory
+TEST_DIR=.
+
+$LLVM_BIN/opt -load $LLVM_SO/CSE231-DFA.so -cse231-gcse -verify -S \
+	$TEST_DIR/CommonSubexpressions.ll -o /tmp/CommonSubexpressions-gcse.ll \
+	2> /tmp/CommonSubexpressions-gcse.result || exit 1
+
+status=0
+expect() {
+	if ! grep -q "$1" $2; then
+		echo "$3"
+		status=1
+	fi
+}
+expectNot() {
+	if grep -q "$1" $2; then
+		echo "$3"
+		status=1
+	fi
+}
+
+# rounds: b2 only matches b1 once a2 is replaced, in a second round
+expect "_Z6roundsii: eliminated 2 common subexpressions in 3 rounds" /tmp/CommonSubexpressions-gcse.result \
+	"rounds did not take two rounds"
+expectNot "%[ab]2 = " /tmp/CommonSubexpressions-gcse.ll "a2 or b2 was kept"
+
+# loop: x * 3 is available from the entry, but i + 1 only comes around the back
+# edge and i * x is computed on one path only
+expectNot "%mul = " /tmp/CommonSubexpressions-gcse.ll "x * 3 was recomputed in the loop"
+expect "%again = add nsw i32 %i, 1" /tmp/CommonSubexpressions-gcse.ll "again was replaced"
+expect "%every = mul nsw i32 %i, %x" /tmp/CommonSubexpressions-gcse.ll "every was replaced"
+
+# flags: the kept instructions only have the flags both copies had
+expect "%s1 = add i32 %x, %y" /tmp/CommonSubexpressions-gcse.ll "s1 kept its nsw flag"
+expect "%g1 = getelementptr \[8 x i32\]" /tmp/CommonSubexpressions-gcse.ll "g1 kept its inbounds flag"
+expectNot "%[sg]2 = " /tmp/CommonSubexpressions-gcse.ll "s2 or g2 was kept"
+
+# the program computes the same result
+$LLVM_BIN/lli $TEST_DIR/CommonSubexpressions.ll; expected=$?
+$LLVM_BIN/lli /tmp/CommonSubexpressions-gcse.ll; actual=$?
+if [ $expected -ne $actual ]; then
+	echo "main returned $actual instead of $expected"
+	status=1
+fi
+exit $status
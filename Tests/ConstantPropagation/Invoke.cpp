@@ -0,0 +1,22 @@
+// The result of a call that may throw is defined by an invoke, a terminator.
+// It is not a constant, so the phi node that merges it with 5 is not either.
+
+int g(int x) {
+	if (x < 0)
+		throw x;
+	return x + 3;
+}
+
+int f(int x) {
+	int r;
+	try {
+		r = g(x);
+	} catch (int) {
+		r = 5;
+	}
+	return r;
+}
+
+int main() {
+	return f(4) + f(-1);
+}
@@ -0,0 +1,57 @@
+; Invoke.cpp after mem2reg (clang++ -O0 -Xclang -disable-O0-optnone, then
+; opt -mem2reg -instnamer), with the exception handling reduced to what f
+; needs: the landing pad catches everything.
+
+@_ZTIi = external constant i8*
+
+declare i8* @__cxa_allocate_exception(i64)
+declare void @__cxa_throw(i8*, i8*, i8*)
+declare i8* @__cxa_begin_catch(i8*)
+declare void @__cxa_end_catch()
+declare i32 @__gxx_personality_v0(...)
+
+define i32 @_Z1gi(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:
+  %exception = call i8* @__cxa_allocate_exception(i64 4)
+  %tmp = bitcast i8* %exception to i32*
+  store i32 %x, i32* %tmp
+  call void @__cxa_throw(i8* %exception, i8* bitcast (i8** @_ZTIi to i8*), i8* null)
+  unreachable
+
+if.end:
+  %add = add nsw i32 %x, 3
+  ret i32 %add
+}
+
+define i32 @_Z1fi(i32 %x) personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*) {
+entry:
+  %call = invoke i32 @_Z1gi(i32 %x)
+          to label %invoke.cont unwind label %lpad
+
+invoke.cont:
+  br label %try.cont
+
+lpad:
+  %lp = landingpad { i8*, i32 }
+          catch i8* null
+  %exn = extractvalue { i8*, i32 } %lp, 0
+  %catch = call i8* @__cxa_begin_catch(i8* %exn)
+  call void @__cxa_end_catch()
+  br label %try.cont
+
+try.cont:
+  %r = phi i32 [ %call, %invoke.cont ], [ 5, %lpad ]
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %call = call i32 @_Z1fi(i32 4)
+  %call1 = call i32 @_Z1fi(i32 -1)
+  %add = add nsw i32 %call, %call1
+  ret i32 %add
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+
+# path to opt and lli
+LLVM_BIN=/LLVM_ROOT/build/bin
+# path to CSE231-DFA.so
+LLVM_SO=/LLVM_ROOT/build/lib
+# path to the test directory
+TEST_DIR=.
+
+$LLVM_BIN/opt -load $LLVM_SO/CSE231-DFA.so -cse231-sccp -verify -S \
+	$TEST_DIR/Invoke.ll -o /tmp/Invoke-sccp.ll 2> /tmp/Invoke-sccp.result || exit 1
+
+# the result of the invoke is not a constant, so neither is the phi node
+status=0
+if ! grep -q "%r = phi i32 \[ %call, %invoke.cont \], \[ 5, %lpad \]" /tmp/Invoke-sccp.ll; then
+	echo "the phi node over the invoke was folded"
+	status=1
+fi
+
+# the program computes the same result
+$LLVM_BIN/lli $TEST_DIR/Invoke.ll; expected=$?
+$LLVM_BIN/lli /tmp/Invoke-sccp.ll; actual=$?
+if [ $expected -ne $actual ]; then
+	echo "main returned $actual instead of $expected"
+	status=1
+fi
+exit $status
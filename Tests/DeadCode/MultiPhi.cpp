@@ -0,0 +1,33 @@
+// Blocks that join several values: after mem2reg each of them gets its own
+// phi node, and the phi nodes whose value is never used are dead.
+
+int join(bool c, int x, int y) {
+	int a, b, unused;
+	if (c) {
+		a = x + 1;
+		b = y;
+		unused = 7;
+	} else {
+		a = x;
+		b = y * 2;
+		unused = 9;
+	}
+	return a + b;
+}
+
+int swap(int x, int y, int n) {
+	int a = x, b = y, last = 0;
+	int i = 0;
+	do {
+		last = i;
+		int t = a;
+		a = b;
+		b = t;
+		++i;
+	} while (i < n);
+	return a - b;
+}
+
+int main() {
+	return join(true, 3, 4) + join(false, 3, 4) + swap(1, 2, 3);
+}
@@ -0,0 +1,50 @@
+; MultiPhi.cpp after mem2reg (clang++ -O0 -Xclang -disable-O0-optnone, then
+; opt -mem2reg -instnamer), with the unused variables kept.
+
+define i32 @_Z4joinbii(i1 zeroext %c, i32 %x, i32 %y) {
+entry:
+  br i1 %c, label %if.then, label %if.else
+
+if.then:
+  %add = add nsw i32 %x, 1
+  br label %if.end
+
+if.else:
+  %mul = mul nsw i32 %y, 2
+  br label %if.end
+
+if.end:
+  %a = phi i32 [ %add, %if.then ], [ %x, %if.else ]
+  %b = phi i32 [ %y, %if.then ], [ %mul, %if.else ]
+  %unused = phi i32 [ 7, %if.then ], [ 9, %if.else ]
+  %add1 = add nsw i32 %a, %b
+  ret i32 %add1
+}
+
+define i32 @_Z4swapiii(i32 %x, i32 %y, i32 %n) {
+entry:
+  br label %do.body
+
+do.body:
+  %i = phi i32 [ 0, %entry ], [ %inc, %do.body ]
+  %a = phi i32 [ %x, %entry ], [ %b, %do.body ]
+  %b = phi i32 [ %y, %entry ], [ %a, %do.body ]
+  %last = phi i32 [ 0, %entry ], [ %i, %do.body ]
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %do.body, label %do.end
+
+do.end:
+  %sub = sub nsw i32 %a, %b
+  ret i32 %sub
+}
+
+define i32 @main() {
+entry:
+  %call = call i32 @_Z4joinbii(i1 zeroext true, i32 3, i32 4)
+  %call1 = call i32 @_Z4joinbii(i1 zeroext false, i32 3, i32 4)
+  %add = add nsw i32 %call, %call1
+  %call2 = call i32 @_Z4swapiii(i32 1, i32 2, i32 3)
+  %add3 = add nsw i32 %add, %call2
+  ret i32 %add3
+}
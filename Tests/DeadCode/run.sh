@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# path to opt and lli
+LLVM_BIN=/LLVM_ROOT/build/bin
+# path to CSE231-DFA.so
+LLVM_SO=/LLVM_ROOT/build/lib
+# path to the test directory
+TEST_DIR=.
+
+$LLVM_BIN/opt -load $LLVM_SO/CSE231-DFA.so -cse231-dce -verify -S \
+	$TEST_DIR/MultiPhi.ll -o /tmp/MultiPhi-dce.ll 2> /tmp/MultiPhi-dce.result || exit 1
+
+# only the phi nodes of the unused variables are dead
+status=0
+for phi in unused last; do
+	if grep -q "%$phi = phi" /tmp/MultiPhi-dce.ll; then
+		echo "dead phi %$phi was kept"
+		status=1
+	fi
+done
+for phi in a b i; do
+	if [ $(grep -c "%$phi = phi" /tmp/MultiPhi-dce.ll) -eq 0 ]; then
+		echo "live phi %$phi was removed"
+		status=1
+	fi
+done
+if grep -q undef /tmp/MultiPhi-dce.ll; then
+	echo "a live value was replaced by undef"
+	status=1
+fi
+
+# the program computes the same result
+$LLVM_BIN/lli $TEST_DIR/MultiPhi.ll; expected=$?
+$LLVM_BIN/lli /tmp/MultiPhi-dce.ll; actual=$?
+if [ $expected -ne $actual ]; then
+	echo "main returned $actual instead of $expected"
+	status=1
+fi
+exit $status
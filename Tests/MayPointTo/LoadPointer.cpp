@@ -0,0 +1,9 @@
+// A pointer loaded from memory points to what was stored there: q gets the
+// address of a through p.
+
+void f() {
+	int a;
+	int *p = &a;
+	int *q = p;
+	*q = 1;
+}
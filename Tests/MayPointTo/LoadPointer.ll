@@ -0,0 +1,14 @@
+; LoadPointer.cpp at -O0 (clang++ -O0 -emit-llvm -S, then opt -instnamer)
+
+define void @_Z1fv() {
+entry:
+  %a = alloca i32, align 4
+  %p = alloca i32*, align 8
+  %q = alloca i32*, align 8
+  store i32* %a, i32** %p, align 8
+  %tmp = load i32*, i32** %p, align 8
+  store i32* %tmp, i32** %q, align 8
+  %tmp1 = load i32*, i32** %q, align 8
+  store i32 1, i32* %tmp1, align 4
+  ret void
+}
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# path to opt
+LLVM_BIN=/LLVM_ROOT/build/bin
+# path to CSE231-DFA.so
+LLVM_SO=/LLVM_ROOT/build/lib
+# path to the test directory
+TEST_DIR=.
+
+# %tmp and %tmp1 (R5 and R7) are loaded from %p and %q, which hold the address
+# of %a (M1), so both point to M1, and the store of %tmp makes %q (M3) too
+$LLVM_BIN/opt -load $LLVM_SO/CSE231-DFA.so -cse231-maypointto -disable-output \
+	< $TEST_DIR/LoadPointer.ll 2> /tmp/LoadPointer.result || exit 1
+diff $TEST_DIR/LoadPointer.expected /tmp/LoadPointer.result
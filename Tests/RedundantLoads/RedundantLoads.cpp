@@ -0,0 +1,41 @@
+// Loads that may and may not read the value stored before them.
+
+int *stashed;
+
+void noop() {}
+
+void stash(int *p) {
+	stashed = p;
+}
+
+void clobberStashed() {
+	*stashed = 99;
+}
+
+// a never escapes, so the call cannot write it: the load reads x
+int keep(int x) {
+	int a = x;
+	noop();
+	return a;
+}
+
+// a escaped through stash, so clobberStashed may write it: the load must stay
+int escaped(int x) {
+	int a;
+	stash(&a);
+	a = x;
+	clobberStashed();
+	return a;
+}
+
+// p and q may be the same pointer: the load must stay
+int throughArgument(int *p, int *q) {
+	*p = 1;
+	*q = 2;
+	return *p;
+}
+
+int main() {
+	int a = 0;
+	return keep(3) + escaped(5) + throughArgument(&a, &a);
+}
@@ -0,0 +1,61 @@
+; RedundantLoads.cpp at -O0 (clang++ -O0 -emit-llvm -S, then opt -instnamer),
+; with the stack slots of the arguments and of the result removed.
+
+@stashed = global i32* null, align 8
+
+define void @_Z4noopv() {
+entry:
+  ret void
+}
+
+define void @_Z5stashPi(i32* %p) {
+entry:
+  store i32* %p, i32** @stashed, align 8
+  ret void
+}
+
+define void @_Z14clobberStashedv() {
+entry:
+  %tmp = load i32*, i32** @stashed, align 8
+  store i32 99, i32* %tmp, align 4
+  ret void
+}
+
+define i32 @_Z4keepi(i32 %x) {
+entry:
+  %a = alloca i32, align 4
+  store i32 %x, i32* %a, align 4
+  call void @_Z4noopv()
+  %keep.load = load i32, i32* %a, align 4
+  ret i32 %keep.load
+}
+
+define i32 @_Z7escapedi(i32 %x) {
+entry:
+  %a = alloca i32, align 4
+  call void @_Z5stashPi(i32* %a)
+  store i32 %x, i32* %a, align 4
+  call void @_Z14clobberStashedv()
+  %escaped.load = load i32, i32* %a, align 4
+  ret i32 %escaped.load
+}
+
+define i32 @_Z15throughArgumentPiS_(i32* %p, i32* %q) {
+entry:
+  store i32 1, i32* %p, align 4
+  store i32 2, i32* %q, align 4
+  %argument.load = load i32, i32* %p, align 4
+  ret i32 %argument.load
+}
+
+define i32 @main() {
+entry:
+  %a = alloca i32, align 4
+  store i32 0, i32* %a, align 4
+  %call = call i32 @_Z4keepi(i32 3)
+  %call1 = call i32 @_Z7escapedi(i32 5)
+  %add = add nsw i32 %call, %call1
+  %call2 = call i32 @_Z15throughArgumentPiS_(i32* %a, i32* %a)
+  %add3 = add nsw i32 %add, %call2
+  ret i32 %add3
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# path to opt and lli
+LLVM_BIN=/LLVM_ROOT/build/bin
+# path to CSE231-DFA.so
+LLVM_SO=/LLVM_ROOT/build/lib
+# path to the test directory
+TEST_DIR=.
+
+$LLVM_BIN/opt -load $LLVM_SO/CSE231-DFA.so -cse231-rle -verify -S \
+	$TEST_DIR/RedundantLoads.ll -o /tmp/RedundantLoads-rle.ll 2> /tmp/RedundantLoads-rle.result || exit 1
+
+# only the load of the alloca that never escapes reads a known value
+status=0
+if grep -q "%keep.load = load" /tmp/RedundantLoads-rle.ll; then
+	echo "the load in keep was not forwarded"
+	status=1
+fi
+for load in escaped argument; do
+	if ! grep -q "%$load.load = load" /tmp/RedundantLoads-rle.ll; then
+		echo "the load in $load was forwarded"
+		status=1
+	fi
+done
+
+# the program computes the same result
+$LLVM_BIN/lli $TEST_DIR/RedundantLoads.ll; expected=$?
+$LLVM_BIN/lli /tmp/RedundantLoads-rle.ll; actual=$?
+if [ $expected -ne $actual ]; then
+	echo "main returned $actual instead of $expected"
+	status=1
+fi
+exit $status
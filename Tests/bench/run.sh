@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# path to opt
+LLVM_BIN=/LLVM_ROOT/build/bin
+# path to CSE231-DFA.so
+LLVM_SO=/LLVM_ROOT/build/lib
+# where the results go
+OUT_DIR=/tmp/bench
+
+# sizes of the generated functions
+SIZES="16 64 256"
+# number of runs of each analysis; the fastest one is reported
+REPS=3
+
+mkdir -p $OUT_DIR
+echo "" > $OUT_DIR/empty.ll
+
+# synthetic functions of every shape and size
+for size in $SIZES; do
+	$LLVM_BIN/opt -load $LLVM_SO/CSE231-DFA.so -cse231-dfa-bench \
+		-cse231-bench-generate=loopnest,switch,straightline,phi,memory \
+		-cse231-bench-size=$size -cse231-bench-reps=$REPS \
+		-disable-output < $OUT_DIR/empty.ll 2> $OUT_DIR/synthetic-$size.result
+done
+
+# any .ll file given on the command line
+for file in "$@"; do
+	$LLVM_BIN/opt -load $LLVM_SO/CSE231-DFA.so -cse231-dfa-bench -cse231-bench-reps=$REPS \
+		-disable-output < $file 2> $OUT_DIR/$(basename $file .ll).result
+done
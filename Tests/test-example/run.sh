@@ -4,7 +4,7 @@
 LLVM_BIN=/LLVM_ROOT/build/bin
 # path to CSE231.so
 LLVM_SO=/LLVM_ROOT/build/lib
-# path to lib231.c
+# path to lib231.cpp (Passes/Runtime in this repository)
 LIB_DIR=/lib231
 # path to the test directory
 TEST_DIR=.